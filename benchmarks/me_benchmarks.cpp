@@ -0,0 +1,332 @@
+#include <benchmark/benchmark.h>
+
+#include <market.hpp>
+#include <memory>
+#include <random>
+#include <vector>
+
+// Every scenario builds its market before the timed loop and keeps the book at a steady size
+// while timing, so the numbers are per operation on a book of the given shape. Random streams
+// use fixed seeds, two runs of one build see exactly the same flow.
+namespace {
+    using lhft::book::OrderId;
+    using lhft::book::Price;
+    using lhft::book::Quantity;
+    using lhft::book::Symbol;
+    using lhft::me::Command;
+    using lhft::me::CommandType;
+    using lhft::me::PooledMarket;
+
+    constexpr Price    MID_PRICE     = 10'000;
+    constexpr Price    BOOK_SPREAD   = 500;    // resting orders sit within this many ticks of the mid
+    constexpr uint32_t RANDOM_SEED   = 42;
+    constexpr size_t   STREAM_LENGTH = 1 << 16;
+
+    struct RestingOrderRef {
+        OrderId id_;
+        Symbol  symbol_;
+        bool    buy_side_;
+        Price   price_;
+    };
+
+    // Passive price for one side, never crossing the mid
+    auto PassivePrice(std::mt19937 &random_engine, bool buy_side) -> Price {
+        Price offset = 1 + random_engine() % BOOK_SPREAD;
+        return buy_side ? MID_PRICE - offset : MID_PRICE + offset;
+    }
+
+    // Fills symbols books with depth resting orders each, half per side
+    auto Seed(PooledMarket &market, std::mt19937 &random_engine, Symbol symbols, std::size_t depth,
+              OrderId &order_id) -> std::vector<RestingOrderRef> {
+        std::vector<RestingOrderRef> resting;
+        resting.reserve(symbols * depth);
+        market.BeginBatch();
+        for (Symbol symbol = 1; symbol <= symbols; ++symbol) {
+            market.AddBook(symbol);
+            for (std::size_t index = 0; index < depth; ++index) {
+                bool  buy_side = index % 2 == 0;
+                Price price    = PassivePrice(random_engine, buy_side);
+                market.OrderSubmit(market.NewOrder(order_id, buy_side, symbol, 1 + random_engine() % 100, price));
+                resting.push_back(RestingOrderRef{order_id++, symbol, buy_side, price});
+            }
+        }
+        market.EndBatch();
+        return resting;
+    }
+
+    // Adds a passive order to a book of range(0) resting orders and cancels it again
+    void BM_DeepBookAddCancel(benchmark::State &state) {
+        PooledMarket market;
+        std::mt19937 random_engine(RANDOM_SEED);
+        OrderId      order_id = 1;
+        Seed(market, random_engine, 1, state.range(0), order_id);
+
+        std::vector<Price> prices(STREAM_LENGTH);
+        for (std::size_t index = 0; index < prices.size(); ++index) {
+            prices[index] = PassivePrice(random_engine, index % 2 == 0);
+        }
+        std::size_t next = 0;
+        for (auto _ : state) {
+            bool buy_side = next % 2 == 0;
+            benchmark::DoNotOptimize(
+                    market.OrderSubmit(market.NewOrder(order_id, buy_side, 1, 10, prices[next % STREAM_LENGTH])));
+            benchmark::DoNotOptimize(market.OrderCancel(order_id));
+            ++order_id;
+            ++next;
+        }
+        state.SetItemsProcessed(state.iterations() * 2);
+    }
+
+    // Cancels random resting orders out of a book of range(0) and refills the book behind them, so
+    // cancels hit every depth and queue position rather than the most recent order
+    void BM_CancelHeavy(benchmark::State &state) {
+        PooledMarket market;
+        std::mt19937 random_engine(RANDOM_SEED);
+        OrderId      order_id = 1;
+        auto         resting  = Seed(market, random_engine, 1, state.range(0), order_id);
+
+        std::vector<std::size_t> victims(STREAM_LENGTH);
+        for (auto &victim : victims) {
+            victim = random_engine() % resting.size();
+        }
+        std::size_t next = 0;
+        for (auto _ : state) {
+            RestingOrderRef &victim = resting[victims[next++ % STREAM_LENGTH]];
+            benchmark::DoNotOptimize(market.OrderCancel(victim.id_));
+            victim.id_ = order_id++;
+            benchmark::DoNotOptimize(
+                    market.OrderSubmit(market.NewOrder(victim.id_, victim.buy_side_, 1, 10, victim.price_)));
+        }
+        state.SetItemsProcessed(state.iterations() * 2);
+    }
+
+    // One aggressive order takes out range(0) full price levels of range(1) orders each. The levels
+    // are put back outside the timed region
+    void BM_AggressiveSweep(benchmark::State &state) {
+        auto         levels    = static_cast<Price>(state.range(0));
+        auto         per_level = static_cast<std::size_t>(state.range(1));
+        PooledMarket market;
+        std::mt19937 random_engine(RANDOM_SEED);
+        OrderId      order_id = 1;
+        Seed(market, random_engine, 1, 0, order_id);
+
+        auto refill = [&] {
+            market.BeginBatch();
+            for (Price price = MID_PRICE + 1; price <= MID_PRICE + levels; ++price) {
+                for (std::size_t index = 0; index < per_level; ++index) {
+                    market.OrderSubmit(market.NewOrder(order_id++, false, 1, 10, price));
+                }
+            }
+            market.EndBatch();
+        };
+        refill();
+        for (auto _ : state) {
+            benchmark::DoNotOptimize(market.OrderSubmit(
+                    market.NewOrder(order_id++, true, 1, levels * per_level * 10, MID_PRICE + levels)));
+            state.PauseTiming();
+            refill();
+            state.ResumeTiming();
+        }
+        state.SetItemsProcessed(state.iterations() * levels * per_level);
+        state.counters["fills"] = benchmark::Counter(static_cast<double>(levels * per_level));
+    }
+
+    // Add and cancel round robin over range(0) books of 1k orders each, the working set grows with
+    // the number of symbols
+    void BM_ManySymbols(benchmark::State &state) {
+        auto         symbols = static_cast<Symbol>(state.range(0));
+        PooledMarket market;
+        std::mt19937 random_engine(RANDOM_SEED);
+        OrderId      order_id = 1;
+        Seed(market, random_engine, symbols, 1'000, order_id);
+
+        std::vector<std::pair<Symbol, Price>> stream(STREAM_LENGTH);
+        for (std::size_t index = 0; index < stream.size(); ++index) {
+            stream[index] = {1 + random_engine() % symbols, PassivePrice(random_engine, index % 2 == 0)};
+        }
+        std::size_t next = 0;
+        for (auto _ : state) {
+            const auto &[symbol, price] = stream[next % STREAM_LENGTH];
+            benchmark::DoNotOptimize(market.OrderSubmit(market.NewOrder(order_id, next % 2 == 0, symbol, 10, price)));
+            benchmark::DoNotOptimize(market.OrderCancel(order_id));
+            ++order_id;
+            ++next;
+        }
+        state.SetItemsProcessed(state.iterations() * 2);
+    }
+
+    // Packets of range(0) passive orders spread over 8 books, submitted and taken out again with
+    // SubmitBatch and CancelBatch when range(1) is set, else one Apply per order in a BeginBatch
+    void BM_SubmitBatch(benchmark::State &state) {
+        constexpr Symbol SYMBOLS = 8;
+        auto             size    = static_cast<std::size_t>(state.range(0));
+        PooledMarket     market;
+        std::mt19937     random_engine(RANDOM_SEED);
+        OrderId          order_id = 1;
+        Seed(market, random_engine, SYMBOLS, 1'000, order_id);
+
+        std::vector<Command> stream(STREAM_LENGTH);
+        for (std::size_t index = 0; index < stream.size(); ++index) {
+            bool buy_side = index % 2 == 0;
+            stream[index] = Command{CommandType::SUBMIT, 0, buy_side, 1 + random_engine() % SYMBOLS, 10,
+                                    PassivePrice(random_engine, buy_side)};
+        }
+        std::vector<Command> packet(size);
+        std::size_t          next = 0;
+        for (auto _ : state) {
+            for (auto &command : packet) {
+                command           = stream[next++ % STREAM_LENGTH];
+                command.order_id_ = order_id++;
+            }
+            if (state.range(1)) {
+                benchmark::DoNotOptimize(market.SubmitBatch(packet));
+                benchmark::DoNotOptimize(market.CancelBatch(packet));
+                continue;
+            }
+            market.BeginBatch();
+            for (const auto &command : packet) {
+                benchmark::DoNotOptimize(market.Apply(command));
+            }
+            for (const auto &command : packet) {
+                benchmark::DoNotOptimize(market.OrderCancel(command.order_id_));
+            }
+            market.EndBatch();
+        }
+        state.SetItemsProcessed(state.iterations() * size * 2);
+    }
+
+    // Cancels all range(0) orders resting in a book: with range(1) in one mass cancel, otherwise
+    // order by order
+    void BM_MassCancel(benchmark::State &state) {
+        for (auto _ : state) {
+            state.PauseTiming();
+            auto         market = std::make_unique<PooledMarket>();
+            std::mt19937 random_engine(RANDOM_SEED);
+            OrderId      order_id = 1;
+            auto         resting  = Seed(*market, random_engine, 1, state.range(0), order_id);
+            state.ResumeTiming();
+            if (state.range(1)) {
+                benchmark::DoNotOptimize(market->OrderMassCancel(1));
+            } else {
+                for (const auto &order : resting) {
+                    benchmark::DoNotOptimize(market->OrderCancel(order.id_));
+                }
+            }
+            state.PauseTiming();
+            market.reset();
+            state.ResumeTiming();
+        }
+        state.SetItemsProcessed(state.iterations() * state.range(0));
+    }
+
+    // Opening backlog of range(0) orders around the mid, crossed both ways, entered into an empty
+    // book: with range(1) in one auction call and a single uncross, otherwise through continuous
+    // matching order by order
+    void BM_OpeningAuction(benchmark::State &state) {
+        constexpr Price OPEN_SPREAD = 50;
+        auto            backlog     = static_cast<std::size_t>(state.range(0));
+        std::mt19937    random_engine(RANDOM_SEED);
+
+        std::vector<Command> stream(backlog);
+        for (std::size_t index = 0; index < stream.size(); ++index) {
+            Price price   = MID_PRICE - OPEN_SPREAD + random_engine() % (2 * OPEN_SPREAD);
+            stream[index] = Command{CommandType::SUBMIT, index + 1, random_engine() % 2 == 0, 1,
+                                    1 + random_engine() % 100, price};
+        }
+        for (auto _ : state) {
+            state.PauseTiming();
+            auto market = std::make_unique<PooledMarket>();
+            market->AddBook(1);
+            state.ResumeTiming();
+            if (state.range(1)) {
+                market->AuctionBegin(1);
+            }
+            for (const auto &command : stream) {
+                benchmark::DoNotOptimize(market->Apply(command));
+            }
+            if (state.range(1)) {
+                benchmark::DoNotOptimize(market->AuctionUncross(1));
+            }
+            state.PauseTiming();
+            market.reset();
+            state.ResumeTiming();
+        }
+        state.SetItemsProcessed(state.iterations() * backlog);
+    }
+
+    // Steady state flow on 8 books: 55% passive adds, 35% cancels of random resting orders and 10%
+    // marketable orders that take liquidity at the touch
+    void BM_SteadyStateMix(benchmark::State &state) {
+        constexpr Symbol SYMBOLS = 8;
+        PooledMarket     market;
+        std::mt19937     random_engine(RANDOM_SEED);
+        OrderId          order_id = 1;
+        auto             resting  = Seed(market, random_engine, SYMBOLS, state.range(0), order_id);
+
+        enum class Op : uint8_t { ADD, CANCEL, TAKE };
+        struct Step {
+            Op          op_;
+            Symbol      symbol_;
+            bool        buy_side_;
+            Price       price_;
+            std::size_t victim_;
+        };
+        std::vector<Step> stream(STREAM_LENGTH);
+        for (auto &step : stream) {
+            auto roll      = random_engine() % 100;
+            step.op_       = roll < 55 ? Op::ADD : roll < 90 ? Op::CANCEL : Op::TAKE;
+            step.symbol_   = 1 + random_engine() % SYMBOLS;
+            step.buy_side_ = random_engine() % 2 == 0;
+            step.price_    = PassivePrice(random_engine, step.buy_side_);
+            step.victim_   = random_engine();
+        }
+        std::size_t next = 0;
+        for (auto _ : state) {
+            const Step &step = stream[next++ % STREAM_LENGTH];
+            switch (step.op_) {
+                case Op::ADD:
+                    market.OrderSubmit(market.NewOrder(order_id, step.buy_side_, step.symbol_, 10, step.price_));
+                    resting.push_back(RestingOrderRef{order_id++, step.symbol_, step.buy_side_, step.price_});
+                    break;
+                case Op::CANCEL: {
+                    if (resting.empty()) {
+                        break;
+                    }
+                    // Swap and pop, the victim may already be gone through a fill
+                    std::size_t victim = step.victim_ % resting.size();
+                    market.OrderCancel(resting[victim].id_);
+                    resting[victim] = resting.back();
+                    resting.pop_back();
+                    break;
+                }
+                case Op::TAKE:
+                    market.OrderSubmit(market.NewOrder(order_id++, step.buy_side_, step.symbol_, 25,
+                                                       step.buy_side_ ? MID_PRICE + BOOK_SPREAD
+                                                                      : MID_PRICE - BOOK_SPREAD));
+                    break;
+            }
+        }
+        state.SetItemsProcessed(state.iterations());
+    }
+}    // namespace
+
+BENCHMARK(BM_DeepBookAddCancel)->Arg(10'000)->Arg(100'000)->Arg(1'000'000);
+BENCHMARK(BM_CancelHeavy)->Arg(10'000)->Arg(100'000)->Arg(1'000'000);
+BENCHMARK(BM_AggressiveSweep)->Args({1, 1})->Args({10, 4})->Args({100, 4})->Args({500, 2});
+BENCHMARK(BM_ManySymbols)->Arg(16)->Arg(256)->Arg(4'096);
+BENCHMARK(BM_SubmitBatch)->ArgsProduct({{1, 16, 256}, {0, 1}});
+BENCHMARK(BM_MassCancel)->ArgsProduct({{10'000, 200'000}, {0, 1}})->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_OpeningAuction)->ArgsProduct({{10'000, 200'000}, {0, 1}})->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_SteadyStateMix)->Arg(1'000)->Arg(50'000);
+
+int main(int argc, char **argv) {
+    // Keep the logger out of the measurements, cancels of orders that already traded log errors
+    lhft::log::Logger::Instance().SetLevel(lhft::log::Level::NONE);
+    benchmark::Initialize(&argc, argv);
+    if (benchmark::ReportUnrecognizedArguments(argc, argv)) {
+        return 1;
+    }
+    benchmark::RunSpecifiedBenchmarks();
+    benchmark::Shutdown();
+    return 0;
+}
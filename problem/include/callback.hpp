@@ -5,8 +5,7 @@
 #include "types.hpp"
 
 namespace lhft::book {
-    template <class OrderPtr>
-    class OrderBook;
+    enum FillFlags { FF_NEITHER_FILLED = 0, FF_INBOUND_FILLED = 1, FF_MATCHED_FILLED = 2, FF_BOTH_FILLED = 4 };
 
     template <typename T>
     std::ostream& operator<<(typename std::enable_if<std::is_enum<T>::value, std::ostream>::type& stream, const T& e) {
@@ -16,8 +15,6 @@ namespace lhft::book {
     template <typename OrderPtr>
     class Callback {
     public:
-        using TypedOrderBook = OrderBook<OrderPtr>;
-
         enum class CbType : int16_t {
             CB_UNKNOWN,
             CB_ORDER_ACCEPT,
@@ -31,8 +28,6 @@ namespace lhft::book {
             CB_SL_TRIGGERED
         };
 
-        enum FillFlags { FF_NEITHER_FILLED = 0, FF_INBOUND_FILLED = 1, FF_MATCHED_FILLED = 2, FF_BOTH_FILLED = 4 };
-
         static auto Accept(const OrderPtr& order) -> Callback<OrderPtr>;
 
         static auto StopLossTriggered(const OrderId& order_id) -> Callback<OrderPtr>;
@@ -51,7 +46,7 @@ namespace lhft::book {
 
         static auto ReplaceReject(const OrderPtr& order, const char* reason) -> Callback<OrderPtr>;
 
-        static auto BookUpdate(const TypedOrderBook* book = nullptr) -> Callback<OrderPtr>;
+        static auto BookUpdate() -> Callback<OrderPtr>;
 
         CbType      type_{CbType::CB_UNKNOWN};
         OrderPtr    order_{nullptr};
@@ -10,7 +10,8 @@ namespace lhft::book {
     template <class OrderPtr>
     auto Callback<OrderPtr>::StopLossTriggered(const OrderId& order_id) -> Callback<OrderPtr> {
         Callback<OrderPtr> result;
-        // TODO
+        result.type_     = CbType::CB_SL_TRIGGERED;
+        result.order_id_ = order_id;
         return result;
     }
 
@@ -59,19 +60,25 @@ namespace lhft::book {
     auto Callback<OrderPtr>::Replace(const OrderPtr& order, const Quantity& curr_open_qty, const int64_t& size_delta,
                                      const Price& new_price) -> Callback<OrderPtr> {
         Callback<OrderPtr> result;
-        // TODO
+        result.type_     = CbType::CB_ORDER_REPLACE;
+        result.order_    = order;
+        result.quantity_ = curr_open_qty;
+        result.delta_    = size_delta;
+        result.price_    = new_price;
         return result;
     }
 
     template <class OrderPtr>
     auto Callback<OrderPtr>::ReplaceReject(const OrderPtr& order, const char* reason) -> Callback<OrderPtr> {
         Callback<OrderPtr> result;
-        // TODO
+        result.type_          = CbType::CB_ORDER_REPLACE_REJECT;
+        result.order_         = order;
+        result.reject_reason_ = reason;
         return result;
     }
 
     template <class OrderPtr>
-    auto Callback<OrderPtr>::BookUpdate(const OrderBook<OrderPtr>* book) -> Callback<OrderPtr> {
+    auto Callback<OrderPtr>::BookUpdate() -> Callback<OrderPtr> {
         Callback<OrderPtr> result;
         result.type_ = CbType::CB_BOOK_UPDATE;
         return result;
@@ -0,0 +1,34 @@
+#pragma once
+
+#include <cstdint>
+
+#include "order.hpp"
+
+namespace lhft::me {
+    enum class CommandType : uint8_t { ADD_BOOK, REMOVE_BOOK, SUBMIT, CANCEL, REPLACE, MASS_CANCEL };
+
+    // Plain record of one request to the matcher, cheap to copy through queues and rings. For
+    // REPLACE quantity_ is the new total quantity and price_ the new price, 0 keeps the current one.
+    // MASS_CANCEL reads owner_, cancel_bids_ and cancel_asks_ as a book::MassCancelFilter.
+    struct Command {
+        CommandType       type_{CommandType::SUBMIT};
+        book::OrderId     order_id_{0};
+        bool              buy_side_{};
+        book::Symbol      symbol_{0};
+        book::Quantity    quantity_{0};
+        book::Price       price_{0};
+        book::TimeInForce time_in_force_{book::TimeInForce::GTC};    // SUBMIT only, like post_only_ and stop_price_
+        bool              post_only_{};
+        book::Price       stop_price_{0};    // 0 for an order that is not a stop
+        book::Owner       owner_{book::ANY_OWNER};    // SUBMIT: the order's owner, MASS_CANCEL: only its orders
+        bool              cancel_bids_{true};         // MASS_CANCEL only, the sides it takes
+        bool              cancel_asks_{true};
+    };
+
+    // Outcome of one command, stream_header_.seq_no_ numbers the reports of one engine
+    struct CommandReport {
+        book::StreamHeader stream_header_{};
+        Command            command_{};
+        bool               result_{};
+    };
+}    // namespace lhft::me
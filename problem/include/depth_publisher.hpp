@@ -0,0 +1,58 @@
+#pragma once
+
+#include <vector>
+
+#include "order.hpp"
+#include "order_listener.hpp"
+#include "types.hpp"
+
+namespace lhft::book {
+    // Turns book operations into market data. Publish emits one BookChange per level touched since
+    // the book's last flush, read from its dirty levels, so the depth is never rescanned;
+    // TakeSnapshot builds a full top SIZE BookData for (re)synchronizing consumers. Both share one
+    // sequence.
+    template <int32_t SIZE = BOOK_DEPTH>
+    class DepthPublisher {
+    public:
+        using Snapshot = BookData<SIZE>;
+        using Changes  = std::vector<BookChange>;
+
+        template <typename Book>
+        auto Publish(const Book &book) -> void;
+
+        template <typename Book>
+        auto TakeSnapshot(const Book &book) -> Snapshot;
+
+        [[nodiscard]] auto GetChanges() const -> const Changes &;
+
+        auto ClearChanges() -> void;
+
+        [[nodiscard]] auto SeqNo() const -> std::size_t;
+
+    private:
+        template <typename Book>
+        static auto FillSide(const Book &book, bool buy_side, std::pair<Price, Quantity> (&levels)[SIZE]) -> void;
+
+        std::size_t seq_no_{0};
+        Changes     changes_{};
+    };
+
+    // Handler that also publishes the depth whenever the book flushes, so the levels of a batch of
+    // operations go out once each with their final quantities
+    template <typename OrderPtr, typename Handler = OrderListener<OrderPtr>, int32_t SIZE = BOOK_DEPTH>
+    class DepthListener : public Handler {
+    public:
+        template <typename Book>
+        auto OnBookUpdate(const Book &book) -> void;
+
+        template <typename Book>
+        auto Flush(const Book &book) -> void;
+
+        auto GetPublisher() -> DepthPublisher<SIZE> &;
+
+    private:
+        DepthPublisher<SIZE> publisher_{};
+    };
+}    // namespace lhft::book
+
+#include "depth_publisher.inl"
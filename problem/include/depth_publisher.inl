@@ -0,0 +1,65 @@
+namespace lhft::book {
+    template <int32_t SIZE>
+    template <typename Book>
+    auto DepthPublisher<SIZE>::Publish(const Book &book) -> void {
+        for (const auto &level : book.GetDirtyLevels()) {
+            changes_.push_back(BookChange{StreamHeader{++seq_no_, BOOK_CHANGE}, book.GetSymbol(), level.buy_side_,
+                                          level.price_, book.LevelQuantity(level.buy_side_, level.price_)});
+        }
+    }
+
+    template <int32_t SIZE>
+    template <typename Book>
+    auto DepthPublisher<SIZE>::TakeSnapshot(const Book &book) -> Snapshot {
+        Snapshot snapshot{};
+        snapshot.stream_header_ = StreamHeader{++seq_no_, BOOK_UPDATE};
+        snapshot.symbol_        = book.GetSymbol();
+        FillSide(book, true, snapshot.bids_);
+        FillSide(book, false, snapshot.asks_);
+        return snapshot;
+    }
+
+    template <int32_t SIZE>
+    auto DepthPublisher<SIZE>::GetChanges() const -> const Changes & {
+        return changes_;
+    }
+
+    template <int32_t SIZE>
+    auto DepthPublisher<SIZE>::ClearChanges() -> void {
+        changes_.clear();
+    }
+
+    template <int32_t SIZE>
+    auto DepthPublisher<SIZE>::SeqNo() const -> std::size_t {
+        return seq_no_;
+    }
+
+    template <int32_t SIZE>
+    template <typename Book>
+    auto DepthPublisher<SIZE>::FillSide(const Book &book, bool buy_side, std::pair<Price, Quantity> (&levels)[SIZE])
+            -> void {
+        LevelView   top[SIZE];
+        std::size_t depth = book.TopLevels(buy_side, SIZE, top);
+        for (std::size_t index = 0; index < depth; ++index) {
+            levels[index] = {top[index].price_, top[index].quantity_};
+        }
+    }
+
+    template <typename OrderPtr, typename Handler, int32_t SIZE>
+    template <typename Book>
+    auto DepthListener<OrderPtr, Handler, SIZE>::OnBookUpdate(const Book &book) -> void {
+        Handler::OnBookUpdate(book);
+    }
+
+    template <typename OrderPtr, typename Handler, int32_t SIZE>
+    template <typename Book>
+    auto DepthListener<OrderPtr, Handler, SIZE>::Flush(const Book &book) -> void {
+        Handler::Flush(book);
+        publisher_.Publish(book);
+    }
+
+    template <typename OrderPtr, typename Handler, int32_t SIZE>
+    auto DepthListener<OrderPtr, Handler, SIZE>::GetPublisher() -> DepthPublisher<SIZE> & {
+        return publisher_;
+    }
+}    // namespace lhft::book
@@ -0,0 +1,75 @@
+#pragma once
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include "command.hpp"
+#include "journal.hpp"
+#include "market.hpp"
+#include "spsc_ring.hpp"
+#include "thread_util.hpp"
+
+namespace lhft::me {
+    // Single matcher fed through a SpscRing of Commands. The gateway thread only copies a Command
+    // into the ring and never waits for the matcher; the engine thread busy polls the ring and
+    // applies the commands to its BasicMarket in batches, flushing each touched book once per batch.
+    template <typename OrderStorage>
+    class BasicEngine {
+    public:
+        using Market = BasicMarket<OrderStorage>;
+
+        explicit BasicEngine(std::size_t capacity = book::COMMAND_RING_CAPACITY,
+                             std::size_t batch_size = book::COMMAND_BATCH_SIZE);
+
+        BasicEngine(const BasicEngine &) = delete;
+
+        auto operator=(const BasicEngine &) -> BasicEngine & = delete;
+
+        ~BasicEngine();
+
+        // Producer side, returns false when the ring is full
+        [[nodiscard]] auto Submit(const Command &command) -> bool;
+
+        // Consumer side, applies at most one batch and returns how many commands it held. A batch the
+        // journal refuses is dropped unapplied, the engine fails and applies nothing from then on
+        auto Poll() -> std::size_t;
+
+        // Runs Poll on a busy polling thread, optionally pinned to core
+        auto Start(int core = -1) -> void;
+
+        // Applies whatever is still queued and joins the polling thread
+        auto Stop() -> void;
+
+        // Each batch is appended and committed to journal before it is applied
+        auto SetJournal(CommandJournal *journal) -> void;
+
+        [[nodiscard]] auto Processed() const -> std::size_t;
+
+        // Set once journaling failed; the market stays at the last committed batch
+        [[nodiscard]] auto Failed() const -> bool;
+
+        // Only safe to use while the polling thread is stopped
+        auto GetMarket() -> Market &;
+
+    private:
+        auto Run() -> void;
+
+        Market                   market_{};
+        SpscRing<Command>        ring_;
+        std::vector<Command>     batch_;
+        CommandJournal *         journal_{nullptr};
+        std::atomic<std::size_t> processed_{0};
+        std::atomic<bool>        running_{false};
+        std::atomic<bool>        failed_{false};
+        std::thread              worker_{};
+    };
+
+    using Engine       = BasicEngine<SharedOrders>;
+    using PooledEngine = BasicEngine<PooledOrders>;
+
+    extern template class BasicEngine<SharedOrders>;
+    extern template class BasicEngine<PooledOrders>;
+}    // namespace lhft::me
+
+#include "engine.inl"
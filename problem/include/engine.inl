@@ -0,0 +1,97 @@
+namespace lhft::me {
+    template <typename OrderStorage>
+    BasicEngine<OrderStorage>::BasicEngine(std::size_t capacity, std::size_t batch_size)
+        : ring_(capacity), batch_(batch_size ? batch_size : 1) {
+    }
+
+    template <typename OrderStorage>
+    BasicEngine<OrderStorage>::~BasicEngine() {
+        Stop();
+    }
+
+    template <typename OrderStorage>
+    auto BasicEngine<OrderStorage>::Submit(const Command &command) -> bool {
+        return ring_.TryPush(command);
+    }
+
+    template <typename OrderStorage>
+    auto BasicEngine<OrderStorage>::Poll() -> std::size_t {
+        if (failed_.load(std::memory_order_relaxed)) {
+            return 0;
+        }
+        std::size_t count = ring_.PopBatch(batch_.data(), batch_.size());
+        if (count) {
+            if (journal_) {
+                bool journaled = true;
+                for (std::size_t index = 0; journaled && index < count; ++index) {
+                    journaled = journal_->Append(batch_[index]);
+                }
+                if (!journaled || !journal_->Commit()) {
+                    // Applying it would leave a market the journal can't rebuild
+                    LOG_ERROR("Journal failed, engine stopped after {} commands", Processed());
+                    failed_.store(true, std::memory_order_release);
+                    running_.store(false, std::memory_order_relaxed);
+                    return 0;
+                }
+            }
+            market_.BeginBatch();
+            for (std::size_t index = 0; index < count; ++index) {
+                market_.Apply(batch_[index]);
+            }
+            market_.EndBatch();
+            processed_.store(processed_.load(std::memory_order_relaxed) + count, std::memory_order_release);
+        }
+        return count;
+    }
+
+    template <typename OrderStorage>
+    auto BasicEngine<OrderStorage>::Start(int core) -> void {
+        if (worker_.joinable() || running_.exchange(true)) {
+            return;
+        }
+        worker_ = std::thread([this] { Run(); });
+        if (core >= 0 && !PinThread(worker_, core)) {
+            LOG_ERROR("Can't pin engine to core {}", core);
+        }
+    }
+
+    template <typename OrderStorage>
+    auto BasicEngine<OrderStorage>::Stop() -> void {
+        // The polling thread may have stopped by itself on a journal failure
+        running_.store(false, std::memory_order_relaxed);
+        if (worker_.joinable()) {
+            worker_.join();
+        }
+    }
+
+    template <typename OrderStorage>
+    auto BasicEngine<OrderStorage>::SetJournal(CommandJournal *journal) -> void {
+        journal_ = journal;
+    }
+
+    template <typename OrderStorage>
+    auto BasicEngine<OrderStorage>::Processed() const -> std::size_t {
+        return processed_.load(std::memory_order_acquire);
+    }
+
+    template <typename OrderStorage>
+    auto BasicEngine<OrderStorage>::Failed() const -> bool {
+        return failed_.load(std::memory_order_acquire);
+    }
+
+    template <typename OrderStorage>
+    auto BasicEngine<OrderStorage>::GetMarket() -> Market & {
+        return market_;
+    }
+
+    template <typename OrderStorage>
+    auto BasicEngine<OrderStorage>::Run() -> void {
+        while (running_.load(std::memory_order_relaxed)) {
+            if (!Poll()) {
+                CpuRelax();
+            }
+        }
+        while (Poll()) {
+        }
+    }
+}    // namespace lhft::me
@@ -0,0 +1,107 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include "command.hpp"
+#include "types.hpp"
+
+namespace lhft::me {
+    struct JournalRecord {
+        uint64_t seq_no_{0};
+        uint64_t timestamp_{0};    // nanoseconds since epoch
+        Command  command_{};
+    };
+
+    struct alignas(64) JournalHeader {
+        char     magic_[8]{};
+        uint32_t version_{0};
+        uint32_t record_size_{0};
+        uint64_t committed_{0};    // records made durable by Commit, readers stop there
+    };
+
+    // Append only journal of inbound commands written through a shared memory map. Appending is a
+    // copy into the map; Commit msyncs everything written since the last commit and then the header
+    // holding the committed count, and runs by itself every commit_every records, so durability costs
+    // two syscalls per group rather than per order. Reopening a journal continues after the last
+    // committed record and drops whatever lies past it.
+    class CommandJournal {
+    public:
+        explicit CommandJournal(std::size_t commit_every = book::JOURNAL_COMMIT_BATCH);
+
+        CommandJournal(const CommandJournal &) = delete;
+
+        auto operator=(const CommandJournal &) -> CommandJournal & = delete;
+
+        ~CommandJournal();
+
+        auto Open(const std::string &file_name, std::size_t capacity = book::JOURNAL_CAPACITY) -> bool;
+
+        auto Append(const Command &command) -> bool;
+
+        auto Commit() -> bool;
+
+        auto Close() -> void;
+
+        [[nodiscard]] auto IsOpen() const -> bool;
+
+        [[nodiscard]] auto Size() const -> std::size_t;
+
+        [[nodiscard]] auto Committed() const -> std::size_t;
+
+    private:
+        auto Map(std::size_t capacity) -> bool;
+
+        auto Unmap() -> void;
+
+        [[nodiscard]] auto Records() const -> JournalRecord *;
+
+        int         fd_{-1};
+        std::byte * base_{nullptr};
+        std::size_t capacity_{0};
+        std::size_t size_{0};
+        std::size_t committed_{0};
+        std::size_t commit_every_;
+    };
+
+    // Read only view of the committed records of a journal, read in place from the map
+    class JournalReader {
+    public:
+        JournalReader() = default;
+
+        JournalReader(const JournalReader &) = delete;
+
+        auto operator=(const JournalReader &) -> JournalReader & = delete;
+
+        ~JournalReader();
+
+        auto Open(const std::string &file_name) -> bool;
+
+        auto Close() -> void;
+
+        [[nodiscard]] auto Size() const -> std::size_t;
+
+        [[nodiscard]] auto At(std::size_t index) const -> const JournalRecord &;
+
+        [[nodiscard]] auto begin() const -> const JournalRecord *;
+
+        [[nodiscard]] auto end() const -> const JournalRecord *;
+
+    private:
+        const std::byte *base_{nullptr};
+        std::size_t      length_{0};
+        std::size_t      size_{0};
+    };
+
+    // Number of complete records among the first committed of a mapped record array: sequence
+    // numbers start at 1 and increase by one, the first record out of line ends the journal
+    auto ValidRecords(const JournalRecord *records, std::size_t committed) -> std::size_t;
+
+    // Applies every record in order to market, batch commands at a time
+    template <typename Market>
+    auto Replay(const JournalReader &journal, Market &market, std::size_t batch = book::COMMAND_BATCH_SIZE)
+            -> std::size_t;
+}    // namespace lhft::me
+
+#include "journal.inl"
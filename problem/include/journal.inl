@@ -0,0 +1,16 @@
+namespace lhft::me {
+    template <typename Market>
+    auto Replay(const JournalReader &journal, Market &market, std::size_t batch) -> std::size_t {
+        std::size_t size = journal.Size();
+        batch            = batch ? batch : 1;
+        for (std::size_t first = 0; first < size; first += batch) {
+            std::size_t last = first + batch < size ? first + batch : size;
+            market.BeginBatch();
+            for (std::size_t index = first; index < last; ++index) {
+                market.Apply(journal.At(index).command_);
+            }
+            market.EndBatch();
+        }
+        return size;
+    }
+}    // namespace lhft::me
@@ -0,0 +1,142 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <vector>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#else
+#include <chrono>
+#endif
+
+namespace lhft::perf {
+    // Timed stages and operations. ADD_FILL is an add that traded on arrival
+    enum class Probe : uint8_t { DECODE, LOOKUP, MATCH, CALLBACK, ADD, ADD_FILL, CANCEL, COUNT };
+
+    auto ProbeName(Probe probe) -> const char *;
+
+    // Raw time stamp counter, converted to nanoseconds only when a histogram is reported
+    class TscClock {
+    public:
+        static auto Now() -> uint64_t {
+#if defined(__x86_64__) || defined(__i386__)
+            return __rdtsc();
+#else
+            return std::chrono::steady_clock::now().time_since_epoch().count();
+#endif
+        }
+
+        // Measured once against steady_clock on first use
+        static auto NsPerTick() -> double;
+    };
+
+    // Log linear histogram of tick counts in the spirit of HdrHistogram: every power of two is split
+    // into SUB_BUCKETS linear buckets, so any value is kept within ~3% across the whole range.
+    // Single writer; readers may merge it while it is being written.
+    class Histogram {
+    public:
+        static constexpr std::size_t SUB_BUCKET_BITS = 5;
+        static constexpr std::size_t SUB_BUCKETS     = 1 << SUB_BUCKET_BITS;
+        static constexpr std::size_t BUCKETS         = (64 - SUB_BUCKET_BITS + 1) * SUB_BUCKETS;
+
+        auto Record(uint64_t ticks) -> void {
+            Bump(counts_[Index(ticks)], 1);
+            Bump(total_, 1);
+            if (ticks > max_.load(std::memory_order_relaxed)) {
+                max_.store(ticks, std::memory_order_relaxed);
+            }
+        }
+
+        auto Merge(const Histogram &other) -> void;
+
+        auto Reset() -> void;
+
+        [[nodiscard]] auto Count() const -> uint64_t;
+
+        [[nodiscard]] auto Max() const -> uint64_t;
+
+        // Upper edge of the bucket holding the given percentile, in ticks
+        [[nodiscard]] auto Percentile(double percentile) const -> uint64_t;
+
+        static auto Index(uint64_t value) -> std::size_t {
+            if (value < SUB_BUCKETS) {
+                return value;
+            }
+            auto shift = static_cast<std::size_t>(63 - __builtin_clzll(value)) - SUB_BUCKET_BITS;
+            return (shift + 1) * SUB_BUCKETS + ((value >> shift) & (SUB_BUCKETS - 1));
+        }
+
+        static auto UpperBound(std::size_t index) -> uint64_t;
+
+    private:
+        // Only the owning thread writes, a plain load and store is enough
+        static auto Bump(std::atomic<uint64_t> &counter, uint64_t delta) -> void {
+            counter.store(counter.load(std::memory_order_relaxed) + delta, std::memory_order_relaxed);
+        }
+
+        std::array<std::atomic<uint64_t>, BUCKETS> counts_{};
+        std::atomic<uint64_t>                      total_{0};
+        std::atomic<uint64_t>                      max_{0};
+    };
+
+    using ProbeHistograms = std::array<Histogram, static_cast<std::size_t>(Probe::COUNT)>;
+
+    // Every thread records into its own set of histograms; a report merges them all. Sets are kept
+    // after their thread exits so nothing recorded is lost.
+    class LatencyRegistry {
+    public:
+        static auto Instance() -> LatencyRegistry &;
+
+        LatencyRegistry(const LatencyRegistry &) = delete;
+
+        auto operator=(const LatencyRegistry &) -> LatencyRegistry & = delete;
+
+        ~LatencyRegistry();
+
+        auto Record(Probe probe, uint64_t ticks) -> void {
+            static thread_local Histogram *local = Local();
+            local[static_cast<std::size_t>(probe)].Record(ticks);
+        }
+
+        // Merges what every thread recorded for probe into result
+        auto Collect(Probe probe, Histogram &result) const -> void;
+
+        // p50/p99/p99.9/max in nanoseconds for every probe that recorded anything
+        auto Dump(std::ostream &os) const -> void;
+
+        auto Reset() -> void;
+
+        // Dump to stdout when the process exits
+        auto SetDumpOnExit(bool dump_on_exit) -> void;
+
+    private:
+        LatencyRegistry() = default;
+
+        auto Local() -> Histogram *;
+
+        mutable std::mutex                            mutex_{};
+        std::vector<std::unique_ptr<ProbeHistograms>> histograms_{};
+        std::atomic<bool>                             dump_on_exit_{false};
+    };
+}    // namespace lhft::perf
+
+#define LATENCY_CONCAT_INNER(a, b) a##b
+#define LATENCY_CONCAT(a, b) LATENCY_CONCAT_INNER(a, b)
+
+// LATENCY_START(name) takes a time stamp, LATENCY_RECORD(probe, name) records the ticks since it.
+// Built without LATENCY_ENABLE both expand to nothing.
+#ifdef LATENCY_ENABLE
+#define LATENCY_START(name) const uint64_t LATENCY_CONCAT(latency_start_, name) = ::lhft::perf::TscClock::Now()
+#define LATENCY_RECORD(probe, name)                  \
+    ::lhft::perf::LatencyRegistry::Instance().Record( \
+            probe, ::lhft::perf::TscClock::Now() - LATENCY_CONCAT(latency_start_, name))
+#else
+#define LATENCY_START(name)
+#define LATENCY_RECORD(probe, name)
+#endif
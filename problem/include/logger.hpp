@@ -1,13 +1,135 @@
 #pragma once
 
-#include <iostream>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace lhft::log {
+    enum class Level : uint8_t { DEBUG, INFO, ERROR, NONE };
+
+    using DecodeFn = auto (*)(std::ostream &os, const char *format, const std::byte *data) -> void;
+
+    // Fixed header in front of every record. A padding record only fills the tail of the ring and
+    // is never decoded, so it only needs the first two fields to fit.
+    struct RecordHeader {
+        uint32_t    size_{0};
+        uint32_t    padding_{0};
+        Level       level_{Level::INFO};
+        const char *format_{nullptr};
+        DecodeFn    decode_{nullptr};
+    };
+
+    // Single producer/single consumer byte ring. Each logging thread owns one, the backend thread
+    // is the only consumer.
+    class LogRing {
+    public:
+        explicit LogRing(std::size_t capacity);
+
+        [[nodiscard]] auto Reserve(std::size_t size) -> std::byte *;
+
+        auto Commit() -> void;
+
+        [[nodiscard]] auto Peek() -> const std::byte *;
+
+        auto Pop(std::size_t size) -> void;
+
+        [[nodiscard]] auto Empty() const -> bool;
+
+        auto Drop() -> void;
+
+        [[nodiscard]] auto Dropped() const -> std::size_t;
+
+        // Set by the owning thread on exit, after its last record
+        auto Retire() -> void;
+
+        [[nodiscard]] auto Retired() const -> bool;
+
+    private:
+        std::vector<std::byte>                buffer_;
+        std::size_t                           mask_;
+        alignas(64) std::atomic<std::size_t> head_{0};
+        std::size_t                           pending_{0};
+        std::size_t                           cached_tail_{0};
+        std::atomic<std::size_t>              dropped_{0};
+        std::atomic<bool>                     retired_{false};
+        alignas(64) std::atomic<std::size_t> tail_{0};
+    };
+
+    // Asynchronous binary logger. The calling thread only copies a record header and the raw
+    // arguments into its own ring; the backend thread substitutes them into the format string
+    // ({} placeholders) and writes the text out. Arguments must be trivially copyable types with an
+    // operator<<, or strings, which are copied. Format strings must be literals.
+    class Logger {
+    public:
+        static auto Instance() -> Logger &;
+
+        Logger(const Logger &) = delete;
+
+        auto operator=(const Logger &) -> Logger & = delete;
+
+        ~Logger();
+
+        auto SetLevel(Level level) -> void;
+
+        [[nodiscard]] auto GetLevel() const -> Level;
+
+        [[nodiscard]] auto Enabled(Level level) const -> bool;
+
+        auto Open(const std::string &file_name) -> bool;
+
+        template <typename... Args>
+        auto Write(Level level, const char *format, const Args &...args) -> void;
+
+        auto Flush() -> void;
+
+        [[nodiscard]] auto Dropped() const -> std::size_t;
+
+        // Rings currently held, one per logging thread that is alive or not drained yet
+        [[nodiscard]] auto Rings() const -> std::size_t;
+
+    private:
+        Logger();
+
+        auto LocalRing() -> LogRing &;
+
+        auto Run() -> void;
+
+        auto Drain() -> bool;
+
+        std::atomic<Level>                    level_{Level::INFO};
+        std::atomic<bool>                     running_{true};
+        mutable std::mutex                    mutex_{};
+        std::vector<std::unique_ptr<LogRing>> rings_{};
+        std::size_t                           retired_dropped_{0};    // drops of the rings already released
+        std::ofstream                         file_{};
+        std::ostream *                        out_{nullptr};
+        std::thread                           backend_{};
+    };
+}    // namespace lhft::log
+
+#include "logger.inl"
+
+#define LOG_WRITE(LEVEL, ...)                                        \
+    do {                                                             \
+        auto &lhft_logger = ::lhft::log::Logger::Instance();         \
+        if (lhft_logger.Enabled(LEVEL)) {                            \
+            lhft_logger.Write(LEVEL, __VA_ARGS__);                   \
+        }                                                            \
+    } while (false)
 
 #ifdef BENCHMARK_ENABLE
-#define LOG_DEBUG(TXT)
-#define LOG_INFO(TXT)
-#define LOG_ERROR(TXT)
+#define LOG_DEBUG(...)
+#define LOG_INFO(...)
+#define LOG_ERROR(...)
 #else
-#define LOG_DEBUG(TXT) std::cout << "DEBUG: " << TXT << '\n'
-#define LOG_INFO(TXT) std::cout << "INFO: " << TXT << '\n'
-#define LOG_ERROR(TXT) std::cout << "ERROR: " << TXT << '\n'
-#endif
\ No newline at end of file
+#define LOG_DEBUG(...) LOG_WRITE(::lhft::log::Level::DEBUG, __VA_ARGS__)
+#define LOG_INFO(...) LOG_WRITE(::lhft::log::Level::INFO, __VA_ARGS__)
+#define LOG_ERROR(...) LOG_WRITE(::lhft::log::Level::ERROR, __VA_ARGS__)
+#endif
@@ -0,0 +1,93 @@
+#include <cstring>
+#include <string_view>
+#include <type_traits>
+
+namespace lhft::log {
+    template <typename T>
+    struct Codec {
+        static_assert(std::is_trivially_copyable_v<T>, "log arguments must be trivially copyable");
+
+        static auto Size(const T &) -> std::size_t {
+            return sizeof(T);
+        }
+
+        static auto Encode(std::byte *out, const T &value) -> std::byte * {
+            std::memcpy(out, &value, sizeof(T));
+            return out + sizeof(T);
+        }
+
+        static auto Decode(std::ostream &os, const std::byte *in) -> const std::byte * {
+            alignas(T) std::byte value[sizeof(T)];
+            std::memcpy(value, in, sizeof(T));
+            os << *std::launder(reinterpret_cast<const T *>(value));
+            return in + sizeof(T);
+        }
+    };
+
+    template <>
+    struct Codec<std::string_view> {
+        static auto Size(std::string_view value) -> std::size_t {
+            return sizeof(uint32_t) + value.size();
+        }
+
+        static auto Encode(std::byte *out, std::string_view value) -> std::byte * {
+            auto length = static_cast<uint32_t>(value.size());
+            std::memcpy(out, &length, sizeof(length));
+            std::memcpy(out + sizeof(length), value.data(), length);
+            return out + sizeof(length) + length;
+        }
+
+        static auto Decode(std::ostream &os, const std::byte *in) -> const std::byte * {
+            uint32_t length = 0;
+            std::memcpy(&length, in, sizeof(length));
+            os.write(reinterpret_cast<const char *>(in + sizeof(length)), length);
+            return in + sizeof(length) + length;
+        }
+    };
+
+    template <>
+    struct Codec<const char *> : Codec<std::string_view> {};
+
+    template <>
+    struct Codec<char *> : Codec<std::string_view> {};
+
+    template <>
+    struct Codec<std::string> : Codec<std::string_view> {};
+
+    template <typename T>
+    using CodecOf = Codec<std::decay_t<T>>;
+
+    inline auto PrintUntilPlaceholder(std::ostream &os, const char *format) -> const char * {
+        const char *placeholder = std::strstr(format, "{}");
+        if (!placeholder) {
+            os << format;
+            return format + std::strlen(format);
+        }
+        os.write(format, placeholder - format);
+        return placeholder + 2;
+    }
+
+    template <typename... Args>
+    auto Decode(std::ostream &os, const char *format, [[maybe_unused]] const std::byte *data) -> void {
+        ((format = PrintUntilPlaceholder(os, format), data = Codec<Args>::Decode(os, data)), ...);
+        os << format;
+    }
+
+    template <typename... Args>
+    auto Logger::Write(Level level, const char *format, const Args &...args) -> void {
+        std::size_t size = sizeof(RecordHeader) + (CodecOf<Args>::Size(args) + ... + 0);
+        size             = (size + 7) & ~std::size_t{7};
+
+        LogRing &  ring = LocalRing();
+        std::byte *out  = ring.Reserve(size);
+        if (!out) {
+            ring.Drop();
+            return;
+        }
+        RecordHeader header{static_cast<uint32_t>(size), 0, level, format, &Decode<std::decay_t<Args>...>};
+        std::memcpy(out, &header, sizeof(header));
+        out += sizeof(header);
+        ((out = CodecOf<Args>::Encode(out, args)), ...);
+        ring.Commit();
+    }
+}    // namespace lhft::log
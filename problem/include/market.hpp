@@ -1,21 +1,87 @@
 #pragma once
+#include <algorithm>
 #include <memory>
+#include <span>
+#include <string>
 #include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
 
+#include "command.hpp"
+#include "latency.hpp"
 #include "order.hpp"
 #include "order_book.hpp"
+#include "order_index.hpp"
+#include "order_pool.hpp"
 
 namespace lhft::me {
-    class Market {
+    // Orders allocated one by one and shared between the market, the books and the callbacks.
+    class SharedOrders {
+    public:
+        using OrderPtr = std::shared_ptr<book::Order>;
+
+        template <typename... Args>
+        auto Create(Args &&...args) -> OrderPtr {
+            return std::make_shared<book::Order>(std::forward<Args>(args)...);
+        }
+
+        auto Destroy(const OrderPtr &) -> void {
+        }
+
+        auto Reserve(std::size_t) -> void {
+        }
+    };
+
+    // Orders carved out of a preallocated slab and passed around as plain pointers. The market owns
+    // every order handed to OrderSubmit and returns it to the pool once it leaves the market, so a
+    // caller must not touch an order after it was filled, cancelled or rejected.
+    class PooledOrders {
+    public:
+        using OrderPtr = book::PoolPtr<book::Order>;
+
+        explicit PooledOrders(std::size_t capacity = book::ORDER_POOL_CAPACITY) : pool_(capacity) {
+        }
+
+        template <typename... Args>
+        auto Create(Args &&...args) -> OrderPtr {
+            return pool_.Create(std::forward<Args>(args)...);
+        }
+
+        auto Destroy(const OrderPtr &order) -> void {
+            pool_.Destroy(order);
+        }
+
+        auto Reserve(std::size_t capacity) -> void {
+            pool_.Reserve(capacity);
+        }
+
+    private:
+        book::ObjectPool<book::Order> pool_;
+    };
+
+    template <typename OrderStorage>
+    class BasicMarket {
     public:
         using OrderId         = book::OrderId;
         using Symbol          = book::Symbol;
-        using OrderPtr        = std::shared_ptr<book::Order>;
+        using OrderPtr        = typename OrderStorage::OrderPtr;
         using OrderBook       = book::OrderBook<OrderPtr>;
         using OrderBookPtr    = std::shared_ptr<OrderBook>;
-        using OrderMap        = std::unordered_map<OrderId, OrderPtr>;
+        using OrderMap        = OrderIndex<OrderPtr>;
         using SymbolToBookMap = std::unordered_map<Symbol, OrderBookPtr>;
 
+        BasicMarket() = default;
+
+        explicit BasicMarket(OrderStorage storage, OrderMap orders = OrderMap());
+
+        // A non zero stop_price makes a stop order, see Order::GetStopPrice
+        auto NewOrder(OrderId order_id, bool buy_side, Symbol symbol, book::Quantity quantity, book::Price price,
+                      book::Price stop_price = 0) -> OrderPtr;
+
+        // Order for a SUBMIT command, time in force, post only, stop price and owner included
+        auto NewOrder(const Command &command) -> OrderPtr;
+
         auto AddBook(Symbol symbol) -> bool;
 
         auto RemoveBook(Symbol symbol) -> bool;
@@ -26,14 +92,86 @@ namespace lhft::me {
 
         auto OrderCancel(OrderId order_id) -> bool;
 
+        // Amends a resting order in its book, see OrderBook::Replace for the priority rules
+        auto OrderReplace(OrderId order_id, int64_t size_delta, book::Price new_price = book::PRICE_UNCHANGED)
+                -> bool;
+
+        // Cancels the orders resting in the book of symbol that pass filter, all of them by default.
+        // Returns how many were cancelled
+        auto OrderMassCancel(Symbol symbol, const book::MassCancelFilter &filter = book::MassCancelFilter())
+                -> std::size_t;
+
+        // Cancels every resting order of owner in every book, as on a session disconnect. ANY_OWNER takes
+        // every order of the market
+        auto OwnerMassCancel(book::Owner owner) -> std::size_t;
+
+        // Starts the call phase of the book of symbol, see OrderBook::BeginAuction
+        auto AuctionBegin(Symbol symbol) -> bool;
+
+        // Uncrosses the book of symbol, returns the auction price or INVALID_LEVEL_PRICE if nothing traded
+        auto AuctionUncross(Symbol symbol) -> book::Price;
+
         auto RemoveOrder(OrderId order_id) -> bool;
 
         auto FindExistingOrder(OrderId order_id, OrderPtr& order, OrderBookPtr& book) -> bool;
 
+        // Executes a queued command, orders for SUBMIT are created from the market's storage
+        auto Apply(const Command &command) -> bool;
+
+        // Submits a packet of orders, every command is read as a SUBMIT. Commands are grouped by symbol,
+        // so each book is looked up once and sees its orders in packet order; orders of different books
+        // may run in another order than they came. Returns how many orders were accepted.
+        auto SubmitBatch(std::span<const Command> commands) -> std::size_t;
+
+        // Cancels the order_id_ of every command in order, returns how many were cancelled
+        auto CancelBatch(std::span<const Command> commands) -> std::size_t;
+
+        // Between BeginBatch and EndBatch the books touched by submits, cancels and replaces are flushed
+        // once, at EndBatch, instead of after every command. SubmitBatch and CancelBatch flush at their
+        // end unless called inside such a batch
+        auto BeginBatch() -> void;
+
+        auto EndBatch() -> void;
+
+        // Writes every book and its resting orders; journal_seq_no records the last journaled command
+        // the snapshot contains, so a restart can replay the journal from the next one
+        auto SaveSnapshot(const std::string &file_name, uint64_t journal_seq_no = 0) const -> bool;
+
+        // Bulk loads a snapshot into an empty market, resting orders go straight into the books. The whole
+        // file is checked first: a truncated file or a duplicate book or order id leaves the market empty
+        auto RestoreSnapshot(const std::string &file_name, uint64_t &journal_seq_no) -> bool;
+
+        // Attaches tape to every current and future book, nullptr detaches it
+        auto SetTradeTape(book::TradeTape *tape) -> void;
+
         auto Log() const -> void;
 
     private:
-        OrderMap        orders_{};
-        SymbolToBookMap books_{};
+        auto Submit(const OrderPtr &order, const OrderBookPtr &book) -> bool;
+
+        auto Cancel(const OrderPtr &order, const OrderBookPtr &book) -> bool;
+
+        auto Touch(const OrderBookPtr &book) -> void;
+
+        // Drops the orders the book's last operation completed, each already in hand so no lookup is needed
+        auto RetireCompleted(const OrderBook &book) -> void;
+
+        // Declared first so that it outlives the books still pointing into it
+        OrderStorage              storage_{};
+        OrderMap                  orders_{};
+        SymbolToBookMap           books_{};
+        book::TradeTape *         trade_tape_{nullptr};
+        bool                      batching_{false};
+        std::vector<OrderBookPtr> touched_{};
+
+        std::vector<std::pair<Symbol, uint32_t>> submit_batch_{};    // symbol and index of each order of SubmitBatch
     };
-}    // namespace lhft::me
\ No newline at end of file
+
+    using Market       = BasicMarket<SharedOrders>;
+    using PooledMarket = BasicMarket<PooledOrders>;
+
+    extern template class BasicMarket<SharedOrders>;
+    extern template class BasicMarket<PooledOrders>;
+}    // namespace lhft::me
+
+#include "market.inl"
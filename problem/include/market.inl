@@ -0,0 +1,449 @@
+namespace lhft::me {
+    template <typename OrderStorage>
+    BasicMarket<OrderStorage>::BasicMarket(OrderStorage storage, OrderMap orders)
+        : storage_(std::move(storage)), orders_(std::move(orders)) {
+    }
+
+    template <typename OrderStorage>
+    auto BasicMarket<OrderStorage>::NewOrder(OrderId order_id, bool buy_side, Symbol symbol, book::Quantity quantity,
+                                             book::Price price, book::Price stop_price) -> OrderPtr {
+        auto order = storage_.Create(order_id, buy_side, symbol, quantity, price);
+        order->SetStopPrice(stop_price);
+        return order;
+    }
+
+    template <typename OrderStorage>
+    auto BasicMarket<OrderStorage>::NewOrder(const Command &command) -> OrderPtr {
+        auto order = NewOrder(command.order_id_, command.buy_side_, command.symbol_, command.quantity_, command.price_,
+                              command.stop_price_);
+        order->SetTimeInForce(command.time_in_force_);
+        order->SetPostOnly(command.post_only_);
+        order->SetOwner(command.owner_);
+        return order;
+    }
+
+    template <typename OrderStorage>
+    auto BasicMarket<OrderStorage>::AddBook(Symbol symbol) -> bool {
+        LOG_INFO("Create new depth order book for {}", symbol);
+        auto [iter, inserted] = books_.insert_or_assign(symbol, std::make_shared<OrderBook>(symbol));
+        iter->second->GetListener().SetTradeTape(trade_tape_);
+        return inserted;
+    }
+
+    template <typename OrderStorage>
+    auto BasicMarket<OrderStorage>::RemoveBook(Symbol symbol) -> bool {
+        bool result = false;
+        auto book   = books_.find(symbol);
+        if (book != books_.end()) {
+            book->second->MassCancel();
+            RetireCompleted(*book->second);
+            result = books_.erase(symbol) == 1;
+        }
+        return result;
+    }
+
+    template <typename OrderStorage>
+    auto BasicMarket<OrderStorage>::FindBook(Symbol symbol) -> OrderBookPtr {
+        OrderBookPtr result = nullptr;
+        auto         entry  = books_.find(symbol);
+        if (entry != books_.end()) {
+            result = entry->second;
+        }
+        return result;
+    }
+
+    template <typename OrderStorage>
+    auto BasicMarket<OrderStorage>::OrderSubmit(const OrderPtr &order) -> bool {
+        bool result = false;
+        if (!order) {
+            LOG_ERROR("Invalid order ref.");
+            return result;
+        }
+        auto symbol = order->GetSymbol();
+        LATENCY_START(lookup);
+        auto book = FindBook(symbol);
+        LATENCY_RECORD(perf::Probe::LOOKUP, lookup);
+        if (!book) {
+            LOG_ERROR("Symbol: {}book not found.", symbol);
+            storage_.Destroy(order);
+            return result;
+        }
+        return Submit(order, book);
+    }
+
+    template <typename OrderStorage>
+    auto BasicMarket<OrderStorage>::Submit(const OrderPtr &order, const OrderBookPtr &book) -> bool {
+        LATENCY_START(submit);
+        auto order_id = order->GetOrderId();
+        LOG_INFO("ADDING order: {}", book::OrderSnapshot(*order));
+        Touch(book);
+        bool inserted = orders_.Insert(order_id, order);
+        if (!inserted) {
+            LOG_ERROR("Duplicate OrderID #{}", order_id);
+            storage_.Destroy(order);
+            return inserted;
+        }
+        bool matched = book->Add(order);
+        if (matched) {
+            LOG_INFO("{} matched", order_id);
+        }
+        RetireCompleted(*book);
+        LATENCY_RECORD(matched ? perf::Probe::ADD_FILL : perf::Probe::ADD, submit);
+        return inserted;
+    }
+
+    template <typename OrderStorage>
+    auto BasicMarket<OrderStorage>::OrderCancel(OrderId order_id) -> bool {
+        OrderPtr     order  = nullptr;
+        OrderBookPtr book   = nullptr;
+        bool         result = false;
+        LATENCY_START(cancel);
+        LATENCY_START(lookup);
+        bool found = FindExistingOrder(order_id, order, book);
+        LATENCY_RECORD(perf::Probe::LOOKUP, lookup);
+        if (found) {
+            result = Cancel(order, book);
+            LATENCY_RECORD(perf::Probe::CANCEL, cancel);
+        }
+        return result;
+    }
+
+    template <typename OrderStorage>
+    auto BasicMarket<OrderStorage>::Cancel(const OrderPtr &order, const OrderBookPtr &book) -> bool {
+        LOG_INFO("Requesting Cancel: {}", book::OrderSnapshot(*order));
+        Touch(book);
+        book->Cancel(order);
+        return RemoveOrder(order->GetOrderId());
+    }
+
+    template <typename OrderStorage>
+    auto BasicMarket<OrderStorage>::OrderReplace(OrderId order_id, int64_t size_delta, book::Price new_price) -> bool {
+        OrderPtr     order = nullptr;
+        OrderBookPtr book  = nullptr;
+        if (!FindExistingOrder(order_id, order, book)) {
+            return false;
+        }
+        LOG_INFO("Requesting Replace: {} {} @{}", book::OrderSnapshot(*order), size_delta, new_price);
+        order->OnReplaceRequested(size_delta, new_price);
+        Touch(book);
+        if (book->Replace(order, size_delta, new_price)) {
+            LOG_INFO("{} matched", order_id);
+        }
+        // Inside a batch the outcome is only known at the flush, until then the request counts as taken
+        bool result = order->CurrentState()->state_ != book::State::MODIFY_REJECTED;
+        RetireCompleted(*book);
+        return result;
+    }
+
+    template <typename OrderStorage>
+    auto BasicMarket<OrderStorage>::RetireCompleted(const OrderBook &book) -> void {
+        for (const auto &order : book.GetCompletedOrders()) {
+            if (orders_.Erase(order->GetOrderId())) {
+                storage_.Destroy(order);
+            }
+        }
+    }
+
+    template <typename OrderStorage>
+    auto BasicMarket<OrderStorage>::OrderMassCancel(Symbol symbol, const book::MassCancelFilter &filter)
+            -> std::size_t {
+        auto book = FindBook(symbol);
+        if (!book) {
+            LOG_ERROR("--No order book for symbol {}", symbol);
+            return 0;
+        }
+        Touch(book);
+        auto cancelled = book->MassCancel(filter);
+        RetireCompleted(*book);
+        return cancelled;
+    }
+
+    template <typename OrderStorage>
+    auto BasicMarket<OrderStorage>::OwnerMassCancel(book::Owner owner) -> std::size_t {
+        std::size_t cancelled = 0;
+        for (const auto &[symbol, book] : books_) {
+            Touch(book);
+            cancelled += book->MassCancel(book::MassCancelFilter{true, true, owner});
+            RetireCompleted(*book);
+        }
+        return cancelled;
+    }
+
+    template <typename OrderStorage>
+    auto BasicMarket<OrderStorage>::AuctionBegin(Symbol symbol) -> bool {
+        auto book = FindBook(symbol);
+        if (!book) {
+            LOG_ERROR("--No order book for symbol {}", symbol);
+            return false;
+        }
+        book->BeginAuction();
+        return true;
+    }
+
+    template <typename OrderStorage>
+    auto BasicMarket<OrderStorage>::AuctionUncross(Symbol symbol) -> book::Price {
+        auto book = FindBook(symbol);
+        if (!book) {
+            LOG_ERROR("--No order book for symbol {}", symbol);
+            return book::INVALID_LEVEL_PRICE;
+        }
+        Touch(book);
+        auto price = book->Uncross();
+        LOG_INFO("Symbol {} uncrossed at {}", symbol, price);
+        RetireCompleted(*book);
+        return price;
+    }
+
+    template <typename OrderStorage>
+    auto BasicMarket<OrderStorage>::RemoveOrder(OrderId order_id) -> bool {
+        auto order = orders_.Find(order_id);
+        if (!order) {
+            return false;
+        }
+        storage_.Destroy(*order);
+        return orders_.Erase(order_id);
+    }
+
+    template <typename OrderStorage>
+    auto BasicMarket<OrderStorage>::FindExistingOrder(OrderId order_id, OrderPtr &order, OrderBookPtr &book)
+            -> bool {
+        auto order_position = orders_.Find(order_id);
+        if (!order_position) {
+            LOG_ERROR("--Can't find OrderID #{}", order_id);
+            return false;
+        }
+
+        order       = *order_position;
+        auto symbol = order->GetSymbol();
+        book        = FindBook(symbol);
+        if (!book) {
+            LOG_ERROR("--No order book for symbol {}", symbol);
+            return false;
+        }
+        return true;
+    }
+
+    template <typename OrderStorage>
+    auto BasicMarket<OrderStorage>::Apply(const Command &command) -> bool {
+        switch (command.type_) {
+            case CommandType::ADD_BOOK:
+                return AddBook(command.symbol_);
+            case CommandType::REMOVE_BOOK:
+                return RemoveBook(command.symbol_);
+            case CommandType::SUBMIT:
+                return OrderSubmit(NewOrder(command));
+            case CommandType::CANCEL:
+                return OrderCancel(command.order_id_);
+            case CommandType::MASS_CANCEL: {
+                book::MassCancelFilter filter{command.cancel_bids_, command.cancel_asks_, command.owner_};
+                return OrderMassCancel(command.symbol_, filter) != 0;
+            }
+            case CommandType::REPLACE: {
+                // The command carries the new total quantity, the book works with the change
+                auto    order      = orders_.Find(command.order_id_);
+                int64_t size_delta = book::SIZE_UNCHANGED;
+                if (order && command.quantity_) {
+                    size_delta = static_cast<int64_t>(command.quantity_) - static_cast<int64_t>((*order)->OrderQty());
+                }
+                return OrderReplace(command.order_id_, size_delta, command.price_);
+            }
+        }
+        return false;
+    }
+
+    template <typename OrderStorage>
+    auto BasicMarket<OrderStorage>::SubmitBatch(std::span<const Command> commands) -> std::size_t {
+        bool nested = batching_;
+        BeginBatch();
+        storage_.Reserve(orders_.Size() + commands.size());
+        orders_.Reserve(orders_.Size() + commands.size());
+
+        // Sorting by symbol then index groups the books and keeps each book's orders in packet order
+        submit_batch_.clear();
+        for (std::size_t index = 0; index < commands.size(); ++index) {
+            submit_batch_.emplace_back(commands[index].symbol_, static_cast<uint32_t>(index));
+        }
+        if (!std::is_sorted(submit_batch_.begin(), submit_batch_.end())) {
+            std::sort(submit_batch_.begin(), submit_batch_.end());
+        }
+
+        std::size_t accepted = 0;
+        for (auto group = submit_batch_.begin(); group != submit_batch_.end();) {
+            Symbol symbol = group->first;
+            auto   next   = group;
+            while (next != submit_batch_.end() && next->first == symbol) {
+                ++next;
+            }
+            auto book = FindBook(symbol);
+            if (!book) {
+                LOG_ERROR("Symbol: {} book not found, {} orders dropped.", symbol, next - group);
+            } else {
+                for (; group != next; ++group) {
+                    accepted += Submit(NewOrder(commands[group->second]), book);
+                }
+            }
+            group = next;
+        }
+        if (!nested) {
+            EndBatch();
+        }
+        return accepted;
+    }
+
+    template <typename OrderStorage>
+    auto BasicMarket<OrderStorage>::CancelBatch(std::span<const Command> commands) -> std::size_t {
+        bool nested = batching_;
+        BeginBatch();
+        std::size_t  cancelled = 0;
+        OrderBookPtr book      = nullptr;
+        for (const auto &command : commands) {
+            auto found = orders_.Find(command.order_id_);
+            if (!found) {
+                LOG_ERROR("--Can't find OrderID #{}", command.order_id_);
+                continue;
+            }
+            OrderPtr order = *found;
+            // Cancels tend to come in runs for one book, which then share a single lookup
+            if (!book || book->GetSymbol() != order->GetSymbol()) {
+                book = FindBook(order->GetSymbol());
+            }
+            if (!book) {
+                LOG_ERROR("--No order book for symbol {}", order->GetSymbol());
+                continue;
+            }
+            cancelled += Cancel(order, book);
+        }
+        if (!nested) {
+            EndBatch();
+        }
+        return cancelled;
+    }
+
+    template <typename OrderStorage>
+    auto BasicMarket<OrderStorage>::BeginBatch() -> void {
+        batching_ = true;
+    }
+
+    template <typename OrderStorage>
+    auto BasicMarket<OrderStorage>::EndBatch() -> void {
+        batching_ = false;
+        for (const auto &book : touched_) {
+            book->SetAutoFlush(true);
+            book->CallbackNow();
+        }
+        touched_.clear();
+    }
+
+    template <typename OrderStorage>
+    auto BasicMarket<OrderStorage>::Touch(const OrderBookPtr &book) -> void {
+        // A book is in touched_ exactly when its auto flush is off
+        if (batching_ && book->AutoFlush()) {
+            book->SetAutoFlush(false);
+            touched_.push_back(book);
+        }
+    }
+
+    template <typename OrderStorage>
+    auto BasicMarket<OrderStorage>::SaveSnapshot(const std::string &file_name, uint64_t journal_seq_no) const
+            -> bool {
+        book::SnapshotWriter writer;
+        writer.Write(book::MakeSnapshotHeader(static_cast<uint32_t>(books_.size()), orders_.Size(), journal_seq_no));
+        for (const auto &[symbol, book] : books_) {
+            book->Save(writer);
+        }
+        if (!writer.Save(file_name)) {
+            LOG_ERROR("Can't write snapshot {}", file_name);
+            return false;
+        }
+        return true;
+    }
+
+    template <typename OrderStorage>
+    auto BasicMarket<OrderStorage>::RestoreSnapshot(const std::string &file_name, uint64_t &journal_seq_no)
+            -> bool {
+        if (!books_.empty() || orders_.Size() != 0) {
+            LOG_ERROR("Snapshot {} can only be restored into an empty market", file_name);
+            return false;
+        }
+        book::SnapshotReader reader;
+        book::SnapshotHeader header;
+        if (!reader.Load(file_name) || !reader.Read(header) || !book::ValidSnapshotHeader(header)) {
+            LOG_ERROR("{} is not a snapshot", file_name);
+            return false;
+        }
+        // The counts are checked against the file size before anything is allocated from them
+        const std::size_t remaining = reader.Remaining();
+        if (header.books_ > remaining / sizeof(book::BookSnapshot) ||
+            header.orders_ > (remaining - header.books_ * sizeof(book::BookSnapshot)) / sizeof(book::RestingOrder)) {
+            LOG_ERROR("Snapshot {} is truncated", file_name);
+            return false;
+        }
+        // Everything is read and checked before the market is touched, so a bad file leaves it empty
+        std::vector<book::BookSnapshot> snapshots(header.books_);
+        std::vector<book::RestingOrder> resting;
+        resting.reserve(header.orders_);
+        std::unordered_set<Symbol>      symbols;
+        std::unordered_set<OrderId>     order_ids;
+        for (auto &snapshot : snapshots) {
+            if (!reader.Read(snapshot)) {
+                LOG_ERROR("Snapshot {} is truncated", file_name);
+                return false;
+            }
+            if (!symbols.insert(snapshot.symbol_).second) {
+                LOG_ERROR("Snapshot {} holds book {} twice", file_name, snapshot.symbol_);
+                return false;
+            }
+            for (uint64_t count = snapshot.bids_ + snapshot.asks_ + snapshot.stops_; count > 0; --count) {
+                if (!reader.Read(resting.emplace_back())) {
+                    LOG_ERROR("Snapshot {} is truncated", file_name);
+                    return false;
+                }
+                if (!order_ids.insert(resting.back().id_).second) {
+                    LOG_ERROR("Snapshot {} holds order {} twice", file_name, resting.back().id_);
+                    return false;
+                }
+            }
+        }
+        if (!reader.AtEnd() || resting.size() != header.orders_) {
+            LOG_ERROR("Snapshot {} does not match its header", file_name);
+            return false;
+        }
+
+        storage_.Reserve(resting.size());
+        orders_.Reserve(resting.size());
+        auto next = resting.cbegin();
+        for (const auto &snapshot : snapshots) {
+            AddBook(snapshot.symbol_);
+            auto book = FindBook(snapshot.symbol_);
+            book->Restore(snapshot);
+            for (uint64_t count = snapshot.bids_ + snapshot.asks_ + snapshot.stops_; count > 0; --count, ++next) {
+                auto order = storage_.Create(next->id_, next->buy_side_, snapshot.symbol_, next->quantity_,
+                                             next->price_);
+                order->SetStopPrice(next->stop_price_);
+                order->SetOwner(next->owner_);
+                order->SetPostOnly(next->post_only_);
+                order->SetTimeInForce(next->time_in_force_);
+                order->OnRestored(next->quantity_on_market_, next->quantity_filled_, next->fill_cost_);
+                orders_.Insert(next->id_, order);
+                book->Restore(order);
+            }
+        }
+        journal_seq_no = header.journal_seq_no_;
+        return true;
+    }
+
+    template <typename OrderStorage>
+    auto BasicMarket<OrderStorage>::SetTradeTape(book::TradeTape *tape) -> void {
+        trade_tape_ = tape;
+        for (const auto &[symbol, book] : books_) {
+            book->GetListener().SetTradeTape(tape);
+        }
+    }
+
+    template <typename OrderStorage>
+    auto BasicMarket<OrderStorage>::Log() const -> void {
+        for (const auto &[symbol, book] : books_) {
+            book->Log();
+        }
+    }
+}    // namespace lhft::me
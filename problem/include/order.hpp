@@ -1,8 +1,8 @@
 #pragma once
 
+#include <array>
 #include <optional>
 #include <ostream>
-#include <sstream>
 #include <string>
 #include <vector>
 
@@ -24,6 +24,9 @@ namespace lhft::book {
         UNKNOWN
     };
 
+    // GTC rests whatever it can't trade, IOC cancels it and FOK only trades if it can fill completely
+    enum class TimeInForce : uint8_t { GTC = 0, IOC = 1, FOK = 2 };
+
     enum TickType : char { ORDER_TICK = 'O', TRADE_EVENT_TICK = 'T', BOOK_UPDATE = 'B', BOOK_CHANGE = 'C' };
 
     struct StreamHeader {
@@ -53,7 +56,7 @@ namespace lhft::book {
         Quantity     quantity_{0};
         Price        price_{0};
         bool         buyer_maker_{};
-        FillId       fill_id_{0};
+        FillId       fill_id_{0};    // unique within symbol_ only
     };
 
     template <int32_t SIZE = BOOK_DEPTH>
@@ -64,23 +67,92 @@ namespace lhft::book {
         std::pair<Price, Quantity> asks_[SIZE];
     };
 
+    // New aggregate of one price level, a quantity of 0 removes the level
     struct BookChange {
         StreamHeader stream_header_{};
         Symbol       symbol_{0};
+        bool         buy_side_{};
+        Price        price_{0};
+        Quantity     quantity_{0};
     };
 
+    // Aggregate of one price level as returned by OrderBook::TopLevels
+    struct LevelView {
+        Price    price_{0};
+        Quantity quantity_{0};
+        uint32_t orders_{0};
+    };
+
+    // Binary record of a lifecycle event. The text form is only rendered when the order is printed,
+    // so recording an event never allocates. reason_ must point to a string with static lifetime.
     struct StateChange {
         State       state_{State::UNKNOWN};
-        std::string description_{};
+        Quantity    quantity_{0};
+        Cost        cost_{0};
+        Price       price_{0};     // SUBMITTED and MODIFY states
+        Symbol      symbol_{0};    // SUBMITTED only, like buy_side_
+        bool        buy_side_{};
+        const char *reason_{nullptr};
 
-        explicit StateChange(State state, const std::string &description = "")
-            : state_(state), description_(description) {
-        }
+        StateChange() = default;
 
-        friend std::ostream &operator<<(std::ostream &os, const StateChange &change) {
-            os /*<< "State: " << change.state_*/ << " Description: " << change.description_;
-            return os;
+        explicit StateChange(State state, Quantity quantity = 0, Cost cost = 0, const char *reason = nullptr)
+            : state_(state), quantity_(quantity), cost_(cost), reason_(reason) {
         }
+
+        friend std::ostream &operator<<(std::ostream &os, const StateChange &change);
+    };
+
+    // Fixed ring of the most recent ORDER_HISTORY_DEPTH events, iterated oldest first.
+    class OrderHistory {
+    public:
+        class const_iterator {
+        public:
+            const_iterator(const OrderHistory *history, std::size_t index) : history_(history), index_(index) {
+            }
+
+            auto operator*() const -> const StateChange & {
+                return (*history_)[index_];
+            }
+
+            auto operator->() const -> const StateChange * {
+                return &(*history_)[index_];
+            }
+
+            auto operator++() -> const_iterator & {
+                ++index_;
+                return *this;
+            }
+
+            auto operator==(const const_iterator &rhs) const -> bool {
+                return index_ == rhs.index_;
+            }
+
+            auto operator!=(const const_iterator &rhs) const -> bool {
+                return index_ != rhs.index_;
+            }
+
+        private:
+            const OrderHistory *history_{nullptr};
+            std::size_t         index_{0};
+        };
+
+        auto Push(const StateChange &change) -> void;
+
+        [[nodiscard]] auto Size() const -> std::size_t;
+
+        [[nodiscard]] auto Empty() const -> bool;
+
+        auto operator[](std::size_t index) const -> const StateChange &;
+
+        [[nodiscard]] auto begin() const -> const_iterator;
+
+        [[nodiscard]] auto end() const -> const_iterator;
+
+    private:
+        std::array<StateChange, ORDER_HISTORY_DEPTH> events_{};
+        std::size_t                                  next_{0};
+        std::size_t                                  size_{0};
     };
 
     struct MatchedTrade {
@@ -94,7 +166,7 @@ namespace lhft::book {
 
     class Order {
     public:
-        using History = std::vector<StateChange>;
+        using History = OrderHistory;
         using Trades  = std::vector<MatchedTrade>;
 
         Order(OrderId id, bool buy_side, Symbol symbol, Quantity quantity, Price price);
@@ -117,6 +189,37 @@ namespace lhft::book {
 
         [[nodiscard]] auto FillCost() const -> Cost;
 
+        [[nodiscard]] auto GetBookHandle() const -> OrderHandle;
+
+        auto SetBookHandle(OrderHandle handle) -> void;
+
+        // A stop order waits off the book until the market trades at or through its stop price, then
+        // enters as a limit order at GetPrice, or as a market order when that is MARKET_ORDER_PRICE
+        [[nodiscard]] auto GetStopPrice() const -> Price;
+
+        auto SetStopPrice(Price stop_price) -> void;
+
+        [[nodiscard]] auto IsStop() const -> bool;
+
+        // Set by the book when the stop is released, like the book handle
+        [[nodiscard]] auto IsTriggered() const -> bool;
+
+        auto SetTriggered(bool triggered) -> void;
+
+        [[nodiscard]] auto GetTimeInForce() const -> TimeInForce;
+
+        auto SetTimeInForce(TimeInForce time_in_force) -> void;
+
+        // A post only order is rejected rather than trade on arrival, it only ever adds liquidity
+        [[nodiscard]] auto IsPostOnly() const -> bool;
+
+        auto SetPostOnly(bool post_only) -> void;
+
+        // Session or account the order belongs to, ANY_OWNER unless set
+        [[nodiscard]] auto GetOwner() const -> Owner;
+
+        auto SetOwner(Owner owner) -> void;
+
         [[nodiscard]] auto GetHistory() const -> const History &;
 
         [[nodiscard]] auto GetTrades() const -> const Trades &;
@@ -134,6 +237,9 @@ namespace lhft::book {
         auto AddTradeHistory(Quantity fill_qty, Quantity remaining_qty, Cost fill_cost, const OrderId &matched_order_id,
                              Price price, FillId fill_id) -> void;
 
+        // Puts back the state of an order loaded from a snapshot, without history or trades
+        auto OnRestored(Quantity quantity_on_market, Quantity quantity_filled, Cost fill_cost) -> void;
+
         auto OnCancelRequested() -> void;
 
         auto OnCancelled() -> void;
@@ -152,17 +258,53 @@ namespace lhft::book {
 
         [[nodiscard]] auto IsVerbose() const -> bool;
 
+        // A lean order keeps only its current state: no event history and no trade list. Market retires
+        // filled orders from what the book reports, so lean orders work under a Market as well.
+        auto SetLean(bool lean) -> void;
+
+        [[nodiscard]] auto IsLean() const -> bool;
+
     private:
-        OrderId  id_{0};
-        bool     buy_side_{};
-        Symbol   symbol_{0};
-        Quantity quantity_{0};
-        Price    price_{0};
-        Quantity quantity_filled_{0};
-        Quantity quantity_on_market_{0};
-        Cost     fill_cost_{0};
-        History  history_{};
-        Trades   trades_{};
-        bool     verbose_{false};
+        auto Record(const StateChange &change) -> void;
+
+        OrderId     id_{0};
+        bool        buy_side_{};
+        Symbol      symbol_{0};
+        Quantity    quantity_{0};
+        Price       price_{0};
+        Quantity    quantity_filled_{0};
+        Quantity    quantity_on_market_{0};
+        Cost        fill_cost_{0};
+        OrderHandle book_handle_{INVALID_ORDER_HANDLE};
+        Price       stop_price_{0};
+        bool        triggered_{false};
+        TimeInForce time_in_force_{TimeInForce::GTC};
+        bool        post_only_{false};
+        Owner       owner_{ANY_OWNER};
+        StateChange last_event_{};
+        History     history_{};
+        Trades      trades_{};
+        bool        verbose_{false};
+        bool        lean_{false};
+    };
+
+    // Trivially copyable copy of the printable part of an order, so that an order can be handed to
+    // the asynchronous logger by value. Prints like a non-verbose Order.
+    struct OrderSnapshot {
+        OrderId     id_{0};
+        bool        buy_side_{};
+        Symbol      symbol_{0};
+        Quantity    quantity_{0};
+        Price       price_{0};
+        Quantity    quantity_on_market_{0};
+        Quantity    quantity_filled_{0};
+        Cost        fill_cost_{0};
+        StateChange last_event_{};
+
+        OrderSnapshot() = default;
+
+        explicit OrderSnapshot(const Order &order);
+
+        friend std::ostream &operator<<(std::ostream &os, const OrderSnapshot &snapshot);
     };
 }    // namespace lhft::book
\ No newline at end of file
@@ -1,62 +1,149 @@
 #pragma once
 
-#include <list>
-#include <map>
+#include <algorithm>
+#include <compare>
+#include <functional>
+#include <numeric>
 #include <vector>
 
-#include "callback.hpp"
+#include "latency.hpp"
 #include "logger.hpp"
+#include "order_listener.hpp"
 #include "order_tracker.hpp"
+#include "price_ladder.hpp"
+#include "snapshot.hpp"
 #include "types.hpp"
 
 namespace lhft::book {
-    template <typename OrderPtr>
+    // Price level changed since the book last flushed
+    struct DirtyLevel {
+        bool  buy_side_{};
+        Price price_{0};
+
+        auto operator<=>(const DirtyLevel &rhs) const = default;
+    };
+
+    // Resting orders a mass cancel takes: either side or both, waiting stops included, and only the
+    // orders of owner unless it is ANY_OWNER
+    struct MassCancelFilter {
+        bool  bids_{true};
+        bool  asks_{true};
+        Owner owner_{ANY_OWNER};
+    };
+
+    // Listener receives every event inline as the book raises it, see OrderListener for the
+    // expected interface and DeferredListener for the queued variant. Stop orders wait in a ladder
+    // of their own per side, keyed by stop price so the next one to trigger is always at the front.
+    template <typename OrderPtr, typename Listener = OrderListener<OrderPtr>>
     class OrderBook {
     public:
-        using Tracker         = OrderTracker<OrderPtr>;
-        using TypedCallback   = Callback<OrderPtr>;
-        using TrackerMap      = std::multimap<ComparablePrice, Tracker>;
-        using DeferredMatches = std::list<typename TrackerMap::iterator>;
-        using TrackerVec      = std::vector<Tracker>;
-        using Callbacks       = std::vector<TypedCallback>;
-        using Bids            = TrackerMap;
-        using Asks            = TrackerMap;
+        using Tracker       = OrderTracker<OrderPtr>;
+        using TrackerLadder = PriceLadder<Tracker>;
+        using TrackerVec    = std::vector<Tracker>;
+        using Bids          = TrackerLadder;
+        using Asks          = TrackerLadder;
 
-        explicit OrderBook(Symbol symbol = 0);
+        explicit OrderBook(Symbol symbol = 0, std::size_t ticks = LADDER_TICKS);
 
         auto SetSymbol(Symbol symbol) -> void;
 
         [[nodiscard]] auto GetSymbol() const -> Symbol;
 
+        // IOC and FOK orders never rest. FOK and post only orders are checked against the level totals
+        // before anything is matched and rejected as a whole.
         [[nodiscard]] auto Add(const OrderPtr &order) -> bool;
 
         auto Cancel(const OrderPtr &order) -> void;
 
-        auto Replace(const OrderPtr &order, int64_t size_delta = SIZE_UNCHANGED, Price new_price = PRICE_UNCHANGED)
-                -> void;
+        // Amends a resting order. A size down at the same price keeps its place in the queue; a new
+        // price or a size up sends it to the back of its level and may trade straight away. Returns
+        // whether the amended order matched.
+        [[nodiscard]] auto Replace(const OrderPtr &order, int64_t size_delta = SIZE_UNCHANGED,
+                                   Price new_price = PRICE_UNCHANGED) -> bool;
+
+        // Starts the call phase of an auction: orders are collected and rest without trading until Uncross.
+        // IOC, FOK and post only orders are refused meanwhile
+        auto BeginAuction() -> void;
+
+        [[nodiscard]] auto InAuction() const -> bool;
+
+        // Ends the call phase and executes everything that crosses at one equilibrium price: the price
+        // with the most executable volume, then the least imbalance, then the one nearest the last trade.
+        // Continuous matching resumes afterwards. Returns the price, INVALID_LEVEL_PRICE if nothing traded
+        auto Uncross() -> Price;
 
         auto MarketPrice(Price price) -> void;
 
         [[nodiscard]] auto MarketPrice() const -> Price;
 
-        auto GetBids() const -> const TrackerMap &;
+        auto GetBids() const -> const TrackerLadder &;
+
+        auto GetAsks() const -> const TrackerLadder &;
+
+        // Waiting buy stops, lowest stop price first
+        auto GetBuyStops() const -> const TrackerLadder &;
 
-        auto GetAsks() const -> const TrackerMap &;
+        // Waiting sell stops, highest stop price first
+        auto GetSellStops() const -> const TrackerLadder &;
 
-        auto MatchOrder(Tracker &inbound, Price inbound_price, TrackerMap &current_orders) -> bool;
+        auto MatchOrder(Tracker &inbound, Price inbound_price, TrackerLadder &current_orders) -> bool;
 
-        auto MatchRegularOrder(Tracker &inbound, Price inbound_price, TrackerMap &current_orders) -> bool;
+        auto MatchRegularOrder(Tracker &inbound, Price inbound_price, TrackerLadder &current_orders) -> bool;
 
         auto CreateTrade(Tracker &inbound_tracker, Tracker &current_tracker, Quantity max_quantity = UINT64_MAX)
                 -> Quantity;
 
-        auto FindOnMarket(const OrderPtr &order, typename TrackerMap::iterator &result) -> bool;
+        auto FindOnMarket(const OrderPtr &order, OrderHandle &result) -> bool;
 
         auto AllOrderCancel() -> std::vector<OrderId>;
 
+        // Cancels every resting order that passes filter in one walk of each ladder, a ladder cancelled as
+        // a whole is cleared in one go. The listener gets a single OnMassCancel and the cancelled orders are
+        // left in GetCompletedOrders. Returns how many were cancelled
+        auto MassCancel(const MassCancelFilter &filter = MassCancelFilter()) -> std::size_t;
+
         auto CallbackNow() -> void;
 
-        auto PerformCallback(TypedCallback &cb) -> void;
+        // With auto flush off Add, Cancel and Replace leave the listener to be flushed by the owner, which
+        // lets a batch of commands share a single CallbackNow
+        auto SetAutoFlush(bool auto_flush) -> void;
+
+        [[nodiscard]] auto AutoFlush() const -> bool;
+
+        auto GetListener() -> Listener &;
+
+        // Levels touched since the last CallbackNow, so an update handled at the end of a batch still
+        // sees the levels of every operation in it. Kept in the order they were touched between
+        // operations; while the book flushes they are sorted by side and price with each level once
+        [[nodiscard]] auto GetDirtyLevels() const -> const std::vector<DirtyLevel> &;
+
+        // Orders the last Add or Replace left with nothing open, inbound and resting alike: filled by a
+        // trade, released stops included, rejected, amended down to nothing, an IOC remainder cancelled
+        // or taken by a mass cancel. Valid until the next operation
+        [[nodiscard]] auto GetCompletedOrders() const -> const std::vector<OrderPtr> &;
+
+        // Best resting limit price of each side, INVALID_LEVEL_PRICE when the side has none
+        [[nodiscard]] auto BestBid() const -> Price;
+
+        [[nodiscard]] auto BestAsk() const -> Price;
+
+        // Level totals are kept as orders come, trade and go, so these read a single level
+        [[nodiscard]] auto LevelQuantity(bool buy_side, Price price) const -> Quantity;
+
+        [[nodiscard]] auto LevelOrders(bool buy_side, Price price) const -> uint32_t;
+
+        // Writes up to depth levels of one side into out, best first, and returns how many were written
+        auto TopLevels(bool buy_side, std::size_t depth, LevelView *out) const -> std::size_t;
+
+        // Writes a BookSnapshot followed by the resting bids, asks and waiting stops
+        auto Save(SnapshotWriter &writer) const -> void;
+
+        // Takes the market price, fill id and auction phase of a saved book
+        auto Restore(const BookSnapshot &snapshot) -> void;
+
+        // Rests a restored order behind the orders already at its level, or with the stops if it is a
+        // waiting stop, without matching or callbacks
+        auto Restore(const OrderPtr &order) -> void;
 
         void Log() const;
 
@@ -65,35 +152,60 @@ namespace lhft::book {
 
         auto AddOrder(Tracker &inbound, Price order_price) -> bool;
 
-        auto OnAccept(const OrderPtr &order, Quantity quantity) -> void;
+        auto MarkDirty(bool buy_side, Price price) -> void;
+
+        // Fills both trackers by fill_qty at cross_price and reports the trade
+        auto Fill(Tracker &inbound_tracker, Tracker &current_tracker, Quantity fill_qty, Price cross_price) -> void;
+
+        // Equilibrium price of the call and the volume that executes there, INVALID_LEVEL_PRICE when
+        // nothing crosses
+        [[nodiscard]] auto AuctionPrice(Quantity &volume) -> Price;
+
+        // Takes fill_qty off the resting order at handle and removes it once filled, returns the order
+        // to carry on with
+        auto Settle(TrackerLadder &side, OrderHandle handle, Quantity fill_qty) -> OrderHandle;
 
-        auto OnReject(const OrderPtr &order, const char *reason) -> void;
+        // Why an order of quantity entering at price must not go ahead, nullptr if it may. Only reads
+        // level totals, so a refused order never touches the book
+        [[nodiscard]] auto Refusal(const OrderPtr &order, Price price, Quantity quantity) const -> const char *;
 
-        auto OnFill(const OrderPtr &order, const OrderPtr &matched_order, Quantity fill_qty, Cost fill_cost,
-                    FillId fill_id) -> void;
+        // Open quantity on the resting side that an order at price could trade with, counted up to wanted
+        [[nodiscard]] auto Available(const TrackerLadder &side, Price price, Quantity wanted) const -> Quantity;
 
-        auto OnCancel(const OrderPtr &order, Quantity quantity) -> void;
+        [[nodiscard]] auto SideOf(const OrderPtr &order) -> TrackerLadder &;
 
-        auto OnCancelReject(const OrderPtr &order, const char *reason) -> void;
+        [[nodiscard]] auto StopCrossed(bool buy_side, Price stop_price) const -> bool;
 
-        auto OnReplace(const OrderPtr &order, Quantity current_qty, Quantity new_qty, Price new_price) -> void;
+        // Takes the orders of side that pass owner off the book into completed_
+        auto MassCancel(TrackerLadder &side, Owner owner) -> void;
 
-        auto OnReplaceReject(const OrderPtr &order, const char *reason) -> void;
+        // Moves every stop crossed by the market price to the back of triggered_
+        auto TriggerStops() -> void;
 
-        auto OnOrderBookChange() -> void;
+        // Enters the triggered stops in the order they were released, including the ones they trigger
+        auto RunTriggered() -> void;
 
-        auto OnStopLossTriggered(const OrderId &order_id) -> void;
+        Symbol        symbol_{0};
+        TrackerLadder bids_;
+        TrackerLadder asks_;
+        TrackerLadder buy_stops_;
+        TrackerLadder sell_stops_;
+        TrackerVec    triggered_{};
+        Price         market_price_{MARKET_ORDER_PRICE};
+        Listener      listener_{};
+        bool          auto_flush_{true};
+        bool          auction_{false};
 
-        auto OnTrade(const OrderBook *book, const OrderId &id_1, const OrderId &id_2, Quantity qty, Price price,
-                     bool buyer_maker) -> void;
+        std::vector<DirtyLevel> dirty_{};
+        std::vector<OrderPtr>   completed_{};
 
-        Symbol     symbol_{0};
-        TrackerMap bids_{};
-        TrackerMap asks_{};
-        Price      market_price_{MARKET_ORDER_PRICE};
-        Callbacks  callbacks_{};
-        Callbacks  working_callbacks_{};
-        bool       handling_callbacks_{false};
+        // Scratch of Uncross, kept to reuse the storage: the levels inside the crossed range and, for
+        // every candidate price, the cumulative quantity bid at or above and offered at or below it
+        std::vector<LevelView> auction_bids_{};
+        std::vector<LevelView> auction_asks_{};
+        std::vector<Price>     auction_prices_{};
+        std::vector<Quantity>  auction_demand_{};
+        std::vector<Quantity>  auction_supply_{};
     };
 }    // namespace lhft::book
 
@@ -1,127 +1,247 @@
 namespace lhft::book {
-    template <class OrderPtr>
-    OrderBook<OrderPtr>::OrderBook(Symbol symbol) : symbol_(symbol) {
-        callbacks_.reserve(16);
-        working_callbacks_.reserve(callbacks_.capacity());
+    template <class OrderPtr, class Listener>
+    OrderBook<OrderPtr, Listener>::OrderBook(Symbol symbol, std::size_t ticks)
+        : symbol_(symbol),
+          bids_(true, ticks),
+          asks_(false, ticks),
+          buy_stops_(false, STOP_LADDER_TICKS),
+          sell_stops_(true, STOP_LADDER_TICKS) {
     }
 
-    template <class OrderPtr>
-    auto OrderBook<OrderPtr>::SetSymbol(Symbol symbol) -> void {
+    template <class OrderPtr, class Listener>
+    auto OrderBook<OrderPtr, Listener>::SetSymbol(Symbol symbol) -> void {
         symbol_ = symbol;
     }
 
-    template <class OrderPtr>
-    auto OrderBook<OrderPtr>::GetSymbol() const -> Symbol {
+    template <class OrderPtr, class Listener>
+    auto OrderBook<OrderPtr, Listener>::GetSymbol() const -> Symbol {
         return symbol_;
     }
 
-    template <class OrderPtr>
-    [[nodiscard]] auto OrderBook<OrderPtr>::Add(const OrderPtr &order) -> bool {
+    template <class OrderPtr, class Listener>
+    [[nodiscard]] auto OrderBook<OrderPtr, Listener>::Add(const OrderPtr &order) -> bool {
         bool matched = false;
+        completed_.clear();
 
+        const char *refusal = nullptr;
         if (order->OrderQty() <= 0) {
-            callbacks_.push_back(TypedCallback::Reject(order, "size must be positive"));
+            refusal = "size must be positive";
+        } else if (!order->IsStop() || StopCrossed(order->IsBuy(), order->GetStopPrice())) {
+            // A waiting stop is checked when it is released instead
+            refusal = Refusal(order, order->GetPrice(), order->OrderQty());
+        }
+        if (refusal) {
+            listener_.OnReject(order, refusal);
+            completed_.push_back(order);
         } else {
-            size_t accept_cb_index = callbacks_.size();
-            callbacks_.push_back(TypedCallback::Accept(order));
+            listener_.OnAccept(order);
             Tracker inbound(order);
-            matched                               = SubmitOrder(inbound);
-            callbacks_[accept_cb_index].quantity_ = inbound.FilledQty();
-            callbacks_.push_back(TypedCallback::BookUpdate(this));
+            LATENCY_START(match);
+            matched = SubmitOrder(inbound);
+            LATENCY_RECORD(perf::Probe::MATCH, match);
+            listener_.OnBookUpdate(*this);
+        }
+        if (auto_flush_) {
+            CallbackNow();
         }
-        CallbackNow();
         return matched;
     }
 
-    template <class OrderPtr>
-    auto OrderBook<OrderPtr>::Cancel(const OrderPtr &order) -> void {
-        bool     found    = false;
-        Quantity open_qty = 0;
-        if (order->IsBuy()) {
-            typename TrackerMap::iterator bid;
-            FindOnMarket(order, bid);
-            if (bid != bids_.end()) {
-                open_qty = bid->second.OpenQty();
-                bids_.erase(bid);
-                found = true;
-            }
-        } else {
-            typename TrackerMap::iterator ask;
-            FindOnMarket(order, ask);
-            if (ask != asks_.end()) {
-                open_qty = ask->second.OpenQty();
-                asks_.erase(ask);
-                found = true;
+    template <class OrderPtr, class Listener>
+    auto OrderBook<OrderPtr, Listener>::Cancel(const OrderPtr &order) -> void {
+        bool        found    = false;
+        Quantity    open_qty = 0;
+        OrderHandle handle   = INVALID_ORDER_HANDLE;
+        if (FindOnMarket(order, handle)) {
+            TrackerLadder &side = SideOf(order);
+            open_qty            = side.At(handle).tracker_.OpenQty();
+            side.Erase(handle);
+            if (&side == &bids_ || &side == &asks_) {
+                MarkDirty(order->IsBuy(), order->GetPrice());
             }
+            order->SetBookHandle(INVALID_ORDER_HANDLE);
+            found = true;
         }
         if (found) {
-            callbacks_.push_back(TypedCallback::Cancel(order, open_qty));
-            callbacks_.push_back(TypedCallback::BookUpdate(this));
+            listener_.OnCancel(order, open_qty);
+            listener_.OnBookUpdate(*this);
+        } else {
+            listener_.OnCancelReject(order, "not found");
+        }
+        if (auto_flush_) {
+            CallbackNow();
+        }
+    }
+
+    template <class OrderPtr, class Listener>
+    auto OrderBook<OrderPtr, Listener>::Replace(const OrderPtr &order, int64_t size_delta, Price new_price) -> bool {
+        bool        matched = false;
+        OrderHandle handle  = INVALID_ORDER_HANDLE;
+        completed_.clear();
+        if (order->IsStop() && !order->IsTriggered()) {
+            listener_.OnReplaceReject(order, "stop not triggered");
+        } else if (!FindOnMarket(order, handle)) {
+            listener_.OnReplaceReject(order, "not found");
         } else {
-            callbacks_.push_back(TypedCallback::CancelReject(order, "not found"));
+            TrackerLadder &side       = order->IsBuy() ? bids_ : asks_;
+            Tracker &      tracker    = side.At(handle).tracker_;
+            Price          price      = side.At(handle).price_.GetPrice();
+            Quantity       open_qty   = tracker.OpenQty();
+            Price          next_price = new_price == PRICE_UNCHANGED ? price : new_price;
+            const char *   refusal    = nullptr;
+            if (size_delta < 0 && open_qty < static_cast<Quantity>(-size_delta)) {
+                refusal = "size reduction larger than open quantity";
+            } else if (next_price != price) {
+                auto next_qty = static_cast<Quantity>(static_cast<int64_t>(open_qty) + size_delta);
+                refusal       = Refusal(order, next_price, next_qty);
+            }
+            if (refusal) {
+                listener_.OnReplaceReject(order, refusal);
+            } else if (next_price == price && size_delta <= 0) {
+                // Same level, smaller or equal size: amended in place, the queue position is kept
+                tracker.ChangeQty(size_delta);
+                side.AdjustLevel(handle, size_delta);
+                MarkDirty(order->IsBuy(), price);
+                if (tracker.Filled()) {
+                    side.Erase(handle);
+                    order->SetBookHandle(INVALID_ORDER_HANDLE);
+                    completed_.push_back(order);
+                }
+                listener_.OnReplace(order, open_qty, size_delta, new_price);
+                listener_.OnBookUpdate(*this);
+            } else {
+                // Loses priority: leaves its level and comes back in as if it had just arrived
+                Tracker amended = tracker;
+                amended.ChangeQty(size_delta);
+                side.Erase(handle);
+                order->SetBookHandle(INVALID_ORDER_HANDLE);
+                MarkDirty(order->IsBuy(), price);
+                listener_.OnReplace(order, open_qty, size_delta, new_price);
+                matched = AddOrder(amended, next_price);
+                RunTriggered();
+                listener_.OnBookUpdate(*this);
+            }
+        }
+        if (auto_flush_) {
+            CallbackNow();
         }
-        CallbackNow();
+        return matched;
     }
 
-    template <class OrderPtr>
-    auto OrderBook<OrderPtr>::Replace(const OrderPtr &order, int64_t size_delta, Price new_price) -> void {
-        // TODO
+    template <class OrderPtr, class Listener>
+    auto OrderBook<OrderPtr, Listener>::BeginAuction() -> void {
+        auction_ = true;
     }
 
-    template <class OrderPtr>
-    auto OrderBook<OrderPtr>::MarketPrice(Price price) -> void {
+    template <class OrderPtr, class Listener>
+    auto OrderBook<OrderPtr, Listener>::InAuction() const -> bool {
+        return auction_;
+    }
+
+    template <class OrderPtr, class Listener>
+    auto OrderBook<OrderPtr, Listener>::Uncross() -> Price {
+        completed_.clear();
+        auction_        = false;
+        Quantity volume = 0;
+        Price    price  = AuctionPrice(volume);
+        if (price != INVALID_LEVEL_PRICE) {
+            // Both sides are walked in priority order, market orders first. Every order ahead of the
+            // last one filled is willing at price, so the volume is used up before either side runs out
+            OrderHandle bid = bids_.Front();
+            OrderHandle ask = asks_.Front();
+            while (volume > 0) {
+                Tracker &buyer    = bids_.At(bid).tracker_;
+                Tracker &seller   = asks_.At(ask).tracker_;
+                Quantity fill_qty = (std::min)(volume, (std::min)(buyer.OpenQty(), seller.OpenQty()));
+                Fill(buyer, seller, fill_qty, price);
+                volume -= fill_qty;
+                bid = Settle(bids_, bid, fill_qty);
+                ask = Settle(asks_, ask, fill_qty);
+            }
+            for (const auto &level : auction_bids_) {
+                if (level.price_ >= price) {
+                    MarkDirty(true, level.price_);
+                }
+            }
+            for (const auto &level : auction_asks_) {
+                if (level.price_ <= price) {
+                    MarkDirty(false, level.price_);
+                }
+            }
+            RunTriggered();
+            listener_.OnBookUpdate(*this);
+        }
+        if (auto_flush_) {
+            CallbackNow();
+        }
+        return price;
+    }
+
+    template <class OrderPtr, class Listener>
+    auto OrderBook<OrderPtr, Listener>::MarketPrice(Price price) -> void {
         market_price_ = price;
     }
 
-    template <class OrderPtr>
-    [[nodiscard]] auto OrderBook<OrderPtr>::MarketPrice() const -> Price {
+    template <class OrderPtr, class Listener>
+    [[nodiscard]] auto OrderBook<OrderPtr, Listener>::MarketPrice() const -> Price {
         return market_price_;
     }
 
-    template <class OrderPtr>
-    auto OrderBook<OrderPtr>::GetBids() const -> const TrackerMap & {
+    template <class OrderPtr, class Listener>
+    auto OrderBook<OrderPtr, Listener>::GetBids() const -> const TrackerLadder & {
         return bids_;
     };
 
-    template <class OrderPtr>
-    auto OrderBook<OrderPtr>::GetAsks() const -> const TrackerMap & {
+    template <class OrderPtr, class Listener>
+    auto OrderBook<OrderPtr, Listener>::GetAsks() const -> const TrackerLadder & {
         return asks_;
     };
 
-    template <class OrderPtr>
-    auto OrderBook<OrderPtr>::MatchOrder(Tracker &inbound, Price inbound_price, TrackerMap &current_orders) -> bool {
+    template <class OrderPtr, class Listener>
+    auto OrderBook<OrderPtr, Listener>::GetBuyStops() const -> const TrackerLadder & {
+        return buy_stops_;
+    }
+
+    template <class OrderPtr, class Listener>
+    auto OrderBook<OrderPtr, Listener>::GetSellStops() const -> const TrackerLadder & {
+        return sell_stops_;
+    }
+
+    template <class OrderPtr, class Listener>
+    auto OrderBook<OrderPtr, Listener>::MatchOrder(Tracker &inbound, Price inbound_price, TrackerLadder &current_orders)
+            -> bool {
         return MatchRegularOrder(inbound, inbound_price, current_orders);
     }
 
-    template <class OrderPtr>
-    auto OrderBook<OrderPtr>::MatchRegularOrder(Tracker &inbound, Price inbound_price, TrackerMap &current_orders)
+    template <class OrderPtr, class Listener>
+    auto OrderBook<OrderPtr, Listener>::MatchRegularOrder(Tracker &inbound, Price inbound_price, TrackerLadder &current_orders)
             -> bool {
-        bool                          matched     = false;
-        Quantity                      inbound_qty = inbound.OpenQty();
-        typename TrackerMap::iterator pos         = current_orders.begin();
-        while (pos != current_orders.end() && !inbound.Filled()) {
-            auto                   entry         = pos++;
-            const ComparablePrice &current_price = entry->first;
+        bool        matched = false;
+        OrderHandle pos     = current_orders.Front();
+        while (pos != INVALID_ORDER_HANDLE && !inbound.Filled()) {
+            OrderHandle            entry         = pos;
+            const ComparablePrice &current_price = current_orders.At(entry).price_;
             if (!current_price.Matches(inbound_price)) {
                 break;
             }
+            pos = current_orders.Next(entry);
 
-            Tracker &current_order    = entry->second;
-            Quantity current_quantity = current_order.OpenQty();
-            Quantity traded           = CreateTrade(inbound, current_order);
+            Tracker &current_order = current_orders.At(entry).tracker_;
+            Quantity traded        = CreateTrade(inbound, current_order);
             if (traded > 0) {
                 matched = true;
+                current_orders.AdjustLevel(entry, -static_cast<int64_t>(traded));
                 if (current_order.Filled()) {
-                    current_orders.erase(entry);
+                    current_order.Ptr()->SetBookHandle(INVALID_ORDER_HANDLE);
+                    current_orders.Erase(entry);
                 }
-                inbound_qty -= traded;
             }
         }
         return matched;
     }
 
-    template <class OrderPtr>
-    auto OrderBook<OrderPtr>::CreateTrade(Tracker &inbound_tracker, Tracker &current_tracker, Quantity max_quantity)
+    template <class OrderPtr, class Listener>
+    auto OrderBook<OrderPtr, Listener>::CreateTrade(Tracker &inbound_tracker, Tracker &current_tracker, Quantity max_quantity)
             -> Quantity {
         Price cross_price = current_tracker.Ptr()->GetPrice();
         // If current order is a market order, cross at inbound price
@@ -137,246 +257,459 @@ namespace lhft::book {
         }
         Quantity fill_qty = (std::min)(max_quantity, (std::min)(inbound_tracker.OpenQty(), current_tracker.OpenQty()));
         if (fill_qty > 0) {
-            inbound_tracker.Fill(fill_qty);
-            current_tracker.Fill(fill_qty);
-            MarketPrice(cross_price);
+            MarkDirty(current_tracker.Ptr()->IsBuy(), current_tracker.Ptr()->GetPrice());
+            Fill(inbound_tracker, current_tracker, fill_qty, cross_price);
+        }
+        return fill_qty;
+    }
 
-            typename TypedCallback::FillFlags fill_flags = TypedCallback::FF_NEITHER_FILLED;
-            if (!inbound_tracker.OpenQty()) {
-                fill_flags = (typename TypedCallback::FillFlags)(fill_flags | TypedCallback::FF_INBOUND_FILLED);
-            }
-            if (!current_tracker.OpenQty()) {
-                fill_flags = (typename TypedCallback::FillFlags)(fill_flags | TypedCallback::FF_MATCHED_FILLED);
-            }
+    template <class OrderPtr, class Listener>
+    auto OrderBook<OrderPtr, Listener>::Fill(Tracker &inbound_tracker, Tracker &current_tracker, Quantity fill_qty,
+                                             Price cross_price) -> void {
+        inbound_tracker.Fill(fill_qty);
+        current_tracker.Fill(fill_qty);
+        bool moved = cross_price != market_price_;
+        MarketPrice(cross_price);
+
+        FillFlags fill_flags = FF_NEITHER_FILLED;
+        if (!inbound_tracker.OpenQty()) {
+            fill_flags = (FillFlags)(fill_flags | FF_INBOUND_FILLED);
+            completed_.push_back(inbound_tracker.Ptr());
+        }
+        if (!current_tracker.OpenQty()) {
+            fill_flags = (FillFlags)(fill_flags | FF_MATCHED_FILLED);
+            completed_.push_back(current_tracker.Ptr());
+        }
 
-            callbacks_.push_back(TypedCallback::Fill(inbound_tracker.Ptr(), current_tracker.Ptr(), fill_qty,
-                                                     cross_price, fill_flags));
+        listener_.OnFill(inbound_tracker.Ptr(), current_tracker.Ptr(), fill_qty, cross_price, fill_flags);
+        if (moved) {
+            TriggerStops();
         }
-        return fill_qty;
     }
 
-    template <class OrderPtr>
-    auto OrderBook<OrderPtr>::FindOnMarket(const OrderPtr &order, typename TrackerMap::iterator &result) -> bool {
-        const ComparablePrice KEY(order->IsBuy(), order->GetPrice());
-        TrackerMap &          side_map = order->IsBuy() ? bids_ : asks_;
+    template <class OrderPtr, class Listener>
+    auto OrderBook<OrderPtr, Listener>::AuctionPrice(Quantity &volume) -> Price {
+        const PriceLevel *market_bids = bids_.Level(MARKET_ORDER_PRICE);
+        const PriceLevel *market_asks = asks_.Level(MARKET_ORDER_PRICE);
+
+        // Only levels inside the crossed range can trade: bids down to the best ask and asks up to the
+        // best bid, or the whole side against resting market orders
+        auto collect = [](const TrackerLadder &side, bool buy_side, Price limit, bool whole_side,
+                          std::vector<LevelView> &levels) {
+            levels.clear();
+            for (Price price = side.BestPrice(); price != INVALID_LEVEL_PRICE;) {
+                if (!whole_side && (limit == INVALID_LEVEL_PRICE || (buy_side ? price < limit : price > limit))) {
+                    break;
+                }
+                const PriceLevel *level = side.Level(price);
+                levels.push_back(LevelView{price, level->quantity_, level->count_});
+                if (!side.NextLevel(price, price)) {
+                    break;
+                }
+            }
+        };
+        collect(bids_, true, asks_.BestPrice(), market_asks != nullptr, auction_bids_);
+        collect(asks_, false, bids_.BestPrice(), market_bids != nullptr, auction_asks_);
+
+        // Both lists merged into one ascending run of candidate prices with the quantity at each
+        auction_prices_.clear();
+        auction_demand_.clear();
+        auction_supply_.clear();
+        auto bid = auction_bids_.rbegin();
+        auto ask = auction_asks_.begin();
+        while (bid != auction_bids_.rend() || ask != auction_asks_.end()) {
+            Price price = bid == auction_bids_.rend()   ? ask->price_
+                          : ask == auction_asks_.end() ? bid->price_
+                                                       : (std::min)(bid->price_, ask->price_);
+            auction_prices_.push_back(price);
+            auction_demand_.push_back(bid != auction_bids_.rend() && bid->price_ == price ? (bid++)->quantity_ : 0);
+            auction_supply_.push_back(ask != auction_asks_.end() && ask->price_ == price ? (ask++)->quantity_ : 0);
+        }
+        if (auction_prices_.empty() && market_bids && market_asks && market_price_ != MARKET_ORDER_PRICE) {
+            // Market orders on their own cross at the last price
+            auction_prices_.push_back(market_price_);
+            auction_demand_.push_back(0);
+            auction_supply_.push_back(0);
+        }
 
-        for (result = side_map.find(KEY); result != side_map.end(); ++result) {
-            if (result->second.Ptr() == order) {
-                return true;
-            } else if (KEY < result->first) {
-                result = side_map.end();
-                return false;
+        // Plain prefix sums over contiguous arrays: demand accumulates from the top, supply from the bottom
+        std::inclusive_scan(auction_demand_.rbegin(), auction_demand_.rend(), auction_demand_.rbegin(), std::plus<>(),
+                            market_bids ? market_bids->quantity_ : Quantity{0});
+        std::inclusive_scan(auction_supply_.begin(), auction_supply_.end(), auction_supply_.begin(), std::plus<>(),
+                            market_asks ? market_asks->quantity_ : Quantity{0});
+
+        // Before any trade market_price_ is 0, so ties left after the imbalance go to the lowest price
+        Price    result    = INVALID_LEVEL_PRICE;
+        Quantity imbalance = 0;
+        Price    distance  = 0;
+        volume             = 0;
+        for (std::size_t index = 0; index < auction_prices_.size(); ++index) {
+            Quantity demand     = auction_demand_[index];
+            Quantity supply     = auction_supply_[index];
+            Quantity executable = (std::min)(demand, supply);
+            Quantity excess     = demand > supply ? demand - supply : supply - demand;
+            Price    price      = auction_prices_[index];
+            Price    away       = price > market_price_ ? price - market_price_ : market_price_ - price;
+            if (executable > volume ||
+                (executable == volume && executable != 0 &&
+                 (excess < imbalance || (excess == imbalance && away < distance)))) {
+                result    = price;
+                volume    = executable;
+                imbalance = excess;
+                distance  = away;
             }
         }
-        return false;
+        return result;
+    }
+
+    template <class OrderPtr, class Listener>
+    auto OrderBook<OrderPtr, Listener>::Settle(TrackerLadder &side, OrderHandle handle, Quantity fill_qty)
+            -> OrderHandle {
+        side.AdjustLevel(handle, -static_cast<int64_t>(fill_qty));
+        if (!side.At(handle).tracker_.Filled()) {
+            return handle;
+        }
+        OrderHandle next = side.Next(handle);
+        side.At(handle).tracker_.Ptr()->SetBookHandle(INVALID_ORDER_HANDLE);
+        side.Erase(handle);
+        return next;
     }
 
-    template <class OrderPtr>
-    auto OrderBook<OrderPtr>::AllOrderCancel() -> std::vector<OrderId> {
-        std::vector<OrderId>  order_id_list;
-        std::vector<OrderPtr> orders;
+    template <class OrderPtr, class Listener>
+    auto OrderBook<OrderPtr, Listener>::FindOnMarket(const OrderPtr &order, OrderHandle &result) -> bool {
+        const TrackerLadder &side = SideOf(order);
 
-        order_id_list.reserve(asks_.size() + bids_.size());
-        orders.reserve(asks_.size() + bids_.size());
+        result = order->GetBookHandle();
+        return result != INVALID_ORDER_HANDLE && side.At(result).tracker_.Ptr() == order;
+    }
 
-        for (auto ask = asks_.rbegin(); ask != asks_.rend(); ++ask) {
-            orders.emplace_back(ask->second.Ptr());
-        }
-        for (auto bid = bids_.begin(); bid != bids_.end(); ++bid) {
-            orders.emplace_back(bid->second.Ptr());
-        }
-        for (const auto &order : orders) {
-            Cancel(order);
+    template <class OrderPtr, class Listener>
+    auto OrderBook<OrderPtr, Listener>::AllOrderCancel() -> std::vector<OrderId> {
+        std::vector<OrderId> order_id_list;
+        order_id_list.reserve(MassCancel());
+        for (const auto &order : completed_) {
             order_id_list.emplace_back(order->GetOrderId());
         }
         return order_id_list;
     }
 
-    template <class OrderPtr>
-    auto OrderBook<OrderPtr>::SubmitOrder(Tracker &inbound) -> bool {
-        Price order_price = inbound.Ptr()->GetPrice();
-        return AddOrder(inbound, order_price);
+    template <class OrderPtr, class Listener>
+    auto OrderBook<OrderPtr, Listener>::MassCancel(const MassCancelFilter &filter) -> std::size_t {
+        completed_.clear();
+        if (filter.bids_) {
+            MassCancel(bids_, filter.owner_);
+            MassCancel(buy_stops_, filter.owner_);
+        }
+        if (filter.asks_) {
+            MassCancel(asks_, filter.owner_);
+            MassCancel(sell_stops_, filter.owner_);
+        }
+        if (!completed_.empty()) {
+            listener_.OnMassCancel(completed_);
+            listener_.OnBookUpdate(*this);
+        }
+        if (auto_flush_) {
+            CallbackNow();
+        }
+        return completed_.size();
+    }
+
+    template <class OrderPtr, class Listener>
+    auto OrderBook<OrderPtr, Listener>::MassCancel(TrackerLadder &side, Owner owner) -> void {
+        bool depth    = &side == &bids_ || &side == &asks_;
+        bool buy_side = &side == &bids_ || &side == &buy_stops_;
+        // Entries come level by level, so MarkDirty sees each price once
+        for (OrderHandle handle = side.Front(); handle != INVALID_ORDER_HANDLE;) {
+            OrderHandle     next  = side.Next(handle);
+            const OrderPtr &order = side.At(handle).tracker_.Ptr();
+            if (owner == ANY_OWNER || order->GetOwner() == owner) {
+                if (depth) {
+                    MarkDirty(buy_side, side.At(handle).price_.GetPrice());
+                }
+                order->SetBookHandle(INVALID_ORDER_HANDLE);
+                completed_.push_back(order);
+                if (owner != ANY_OWNER) {
+                    side.Erase(handle);
+                }
+            }
+            handle = next;
+        }
+        if (owner == ANY_OWNER) {
+            side.Clear();
+        }
+    }
+
+    template <class OrderPtr, class Listener>
+    auto OrderBook<OrderPtr, Listener>::SubmitOrder(Tracker &inbound) -> bool {
+        const OrderPtr &order = inbound.Ptr();
+        if (order->IsStop() && !order->IsTriggered()) {
+            if (!StopCrossed(order->IsBuy(), order->GetStopPrice())) {
+                TrackerLadder &stops = order->IsBuy() ? buy_stops_ : sell_stops_;
+                order->SetBookHandle(stops.Insert(inbound, order->GetStopPrice()));
+                return false;
+            }
+            // Already through the stop price, enters straight away
+            order->SetTriggered(true);
+            listener_.OnStopLossTriggered(order->GetOrderId());
+        }
+        bool matched = AddOrder(inbound, order->GetPrice());
+        RunTriggered();
+        return matched;
     }
 
-    template <class OrderPtr>
-    auto OrderBook<OrderPtr>::AddOrder(Tracker &inbound, Price order_price) -> bool {
+    template <class OrderPtr, class Listener>
+    auto OrderBook<OrderPtr, Listener>::AddOrder(Tracker &inbound, Price order_price) -> bool {
         bool      matched = false;
         OrderPtr &order   = inbound.Ptr();
-        if (order->IsBuy()) {
+        if (auction_) {
+            // Nothing trades during the call, the order waits for the uncross
+        } else if (order->IsBuy()) {
             matched = MatchOrder(inbound, order_price, asks_);
         } else {
             matched = MatchOrder(inbound, order_price, bids_);
         }
 
-        if (inbound.OpenQty()) {
+        if (inbound.OpenQty() && order->GetTimeInForce() != TimeInForce::GTC) {
+            // What an IOC could not trade goes away without ever resting
+            listener_.OnCancel(order, inbound.OpenQty());
+            completed_.push_back(order);
+        } else if (inbound.OpenQty()) {
             if (order->IsBuy()) {
-                bids_.insert({ComparablePrice(true, order_price), inbound});
+                order->SetBookHandle(bids_.Insert(inbound, order_price));
             } else {
-                asks_.insert({ComparablePrice(false, order_price), inbound});
+                order->SetBookHandle(asks_.Insert(inbound, order_price));
             }
+            MarkDirty(order->IsBuy(), order_price);
         }
         return matched;
     }
 
-    template <class OrderPtr>
-    auto OrderBook<OrderPtr>::OnAccept(const OrderPtr &order, Quantity quantity) -> void {
-        order->OnAccepted();
-        LOG_INFO("Event: Accepted: " << *order);
+    template <class OrderPtr, class Listener>
+    auto OrderBook<OrderPtr, Listener>::MarkDirty(bool buy_side, Price price) -> void {
+        // Market orders are not part of the depth. A sweep touches each level in a row, so only
+        // the last entry needs checking for duplicates
+        if (price == MARKET_ORDER_PRICE) {
+            return;
+        }
+        if (!dirty_.empty() && dirty_.back().buy_side_ == buy_side && dirty_.back().price_ == price) {
+            return;
+        }
+        dirty_.push_back(DirtyLevel{buy_side, price});
     }
 
-    template <class OrderPtr>
-    auto OrderBook<OrderPtr>::OnReject(const OrderPtr &order, const char *reason) -> void {
-        order->OnRejected(reason);
-        LOG_INFO("Event: Rejected: " << *order << ' ' << reason);
+    template <class OrderPtr, class Listener>
+    auto OrderBook<OrderPtr, Listener>::Refusal(const OrderPtr &order, Price price, Quantity quantity) const
+            -> const char * {
+        if (auction_ && (order->GetTimeInForce() != TimeInForce::GTC || order->IsPostOnly())) {
+            return "not accepted during an auction call";
+        }
+        const TrackerLadder &resting = order->IsBuy() ? asks_ : bids_;
+        if (order->IsPostOnly() && Available(resting, price, 1) != 0) {
+            return "post only order would trade";
+        }
+        if (order->GetTimeInForce() == TimeInForce::FOK && Available(resting, price, quantity) < quantity) {
+            return "fill or kill order can't fill";
+        }
+        return nullptr;
     }
 
-    template <class OrderPtr>
-    auto OrderBook<OrderPtr>::OnFill(const OrderPtr &order, const OrderPtr &matched_order, Quantity fill_qty,
-                                     Cost fill_cost, FillId fill_id) -> void {
-        order->OnFilled(fill_qty, fill_cost);
-        matched_order->OnFilled(fill_qty, fill_cost);
+    template <class OrderPtr, class Listener>
+    auto OrderBook<OrderPtr, Listener>::Available(const TrackerLadder &side, Price price, Quantity wanted) const
+            -> Quantity {
+        Quantity available = 0;
+        // Resting market orders trade with anything that has a price to cross at
+        const PriceLevel *market = side.Level(MARKET_ORDER_PRICE);
+        if (market && (price != MARKET_ORDER_PRICE || market_price_ != MARKET_ORDER_PRICE)) {
+            available += market->quantity_;
+        }
+        for (Price level = side.BestPrice(); available < wanted && level != INVALID_LEVEL_PRICE;) {
+            if (!ComparablePrice(&side == &bids_, level).Matches(price)) {
+                break;
+            }
+            available += side.Level(level)->quantity_;
+            if (!side.NextLevel(level, level)) {
+                break;
+            }
+        }
+        return available;
+    }
 
-        std::stringstream out;
-        out << (order->IsBuy() ? "Event: Fill-Bought: " : "Event: Fill-Sold: ") << fill_qty << " Shares for "
-            << fill_cost << ' ' << *order;
-        out << (matched_order->IsBuy() ? " Bought: " : " Sold: ") << fill_qty << " Shares for " << fill_cost << ' '
-            << *matched_order;
-        LOG_INFO(out.str());
+    template <class OrderPtr, class Listener>
+    auto OrderBook<OrderPtr, Listener>::SideOf(const OrderPtr &order) -> TrackerLadder & {
+        if (order->IsStop() && !order->IsTriggered()) {
+            return order->IsBuy() ? buy_stops_ : sell_stops_;
+        }
+        return order->IsBuy() ? bids_ : asks_;
+    }
 
-        order->AddTradeHistory(fill_qty, matched_order->QuantityOnMarket(), fill_cost, matched_order->GetOrderId(),
-                               matched_order->GetPrice(), fill_id);
-        matched_order->AddTradeHistory(fill_qty, order->QuantityOnMarket(), fill_cost, order->GetOrderId(),
-                                       order->GetPrice(), fill_id);
+    template <class OrderPtr, class Listener>
+    auto OrderBook<OrderPtr, Listener>::StopCrossed(bool buy_side, Price stop_price) const -> bool {
+        if (market_price_ == MARKET_ORDER_PRICE) {
+            return false;
+        }
+        return buy_side ? market_price_ >= stop_price : market_price_ <= stop_price;
     }
 
-    template <class OrderPtr>
-    auto OrderBook<OrderPtr>::OnCancel(const OrderPtr &order, Quantity quantity) -> void {
-        order->OnCancelled();
-        LOG_INFO("Event: Canceled: " << *order);
+    template <class OrderPtr, class Listener>
+    auto OrderBook<OrderPtr, Listener>::TriggerStops() -> void {
+        // Both ladders keep the stop closest to the market at the front, so the crossed stops are a
+        // prefix of each and nothing beyond the first stop left waiting is looked at
+        for (TrackerLadder *stops : {&buy_stops_, &sell_stops_}) {
+            bool buy_side = stops == &buy_stops_;
+            for (OrderHandle front = stops->Front();
+                 front != INVALID_ORDER_HANDLE && StopCrossed(buy_side, stops->At(front).price_.GetPrice());
+                 front = stops->Front()) {
+                const OrderPtr &order = stops->At(front).tracker_.Ptr();
+                order->SetTriggered(true);
+                order->SetBookHandle(INVALID_ORDER_HANDLE);
+                listener_.OnStopLossTriggered(order->GetOrderId());
+                triggered_.push_back(stops->At(front).tracker_);
+                stops->Erase(front);
+            }
+        }
     }
 
-    template <class OrderPtr>
-    auto OrderBook<OrderPtr>::OnCancelReject(const OrderPtr &order, const char *reason) -> void {
-        order->OnCancelRejected(reason);
-        LOG_INFO("Event: Cancel Reject: " << *order << ' ' << reason);
+    template <class OrderPtr, class Listener>
+    auto OrderBook<OrderPtr, Listener>::RunTriggered() -> void {
+        // A released stop that trades may release more stops, they join the back of the queue. Every
+        // stop is extracted once and matched once however long the cascade runs
+        for (std::size_t next = 0; next < triggered_.size(); ++next) {
+            Tracker         inbound = triggered_[next];
+            const OrderPtr &order   = inbound.Ptr();
+            if (Refusal(order, order->GetPrice(), inbound.OpenQty())) {
+                // Accepted when it arrived, so it is cancelled rather than rejected
+                listener_.OnCancel(order, inbound.OpenQty());
+                completed_.push_back(order);
+                continue;
+            }
+            AddOrder(inbound, order->GetPrice());
+        }
+        triggered_.clear();
     }
 
-    template <class OrderPtr>
-    auto OrderBook<OrderPtr>::OnReplace(const OrderPtr &order, Quantity current_qty, Quantity new_qty, Price new_price)
-            -> void {
-        // TODO
+    template <class OrderPtr, class Listener>
+    auto OrderBook<OrderPtr, Listener>::GetDirtyLevels() const -> const std::vector<DirtyLevel> & {
+        return dirty_;
     }
 
-    template <class OrderPtr>
-    auto OrderBook<OrderPtr>::OnReplaceReject(const OrderPtr &order, const char *reason) -> void {
-        // TODO
+    template <class OrderPtr, class Listener>
+    auto OrderBook<OrderPtr, Listener>::GetCompletedOrders() const -> const std::vector<OrderPtr> & {
+        return completed_;
     }
 
-    template <class OrderPtr>
-    auto OrderBook<OrderPtr>::OnOrderBookChange() -> void {
-        // TODO
+    template <class OrderPtr, class Listener>
+    auto OrderBook<OrderPtr, Listener>::BestBid() const -> Price {
+        return bids_.BestPrice();
     }
 
-    template <class OrderPtr>
-    auto OrderBook<OrderPtr>::OnStopLossTriggered(const OrderId &order_id) -> void {
-        // TODO
+    template <class OrderPtr, class Listener>
+    auto OrderBook<OrderPtr, Listener>::BestAsk() const -> Price {
+        return asks_.BestPrice();
     }
 
-    template <class OrderPtr>
-    auto OrderBook<OrderPtr>::OnTrade(const OrderBook *book, const OrderId &id_1, const OrderId &id_2, Quantity qty,
-                                      Price price, bool buyer_maker) -> void {
-        // TODO
+    template <class OrderPtr, class Listener>
+    auto OrderBook<OrderPtr, Listener>::LevelQuantity(bool buy_side, Price price) const -> Quantity {
+        const PriceLevel *level = (buy_side ? bids_ : asks_).Level(price);
+        return level ? level->quantity_ : 0;
     }
 
-    template <class OrderPtr>
-    auto OrderBook<OrderPtr>::CallbackNow() -> void {
-        if (!handling_callbacks_) {
-            handling_callbacks_ = true;
-            while (!callbacks_.empty()) {
-                working_callbacks_.reserve(callbacks_.capacity());
-                working_callbacks_.swap(callbacks_);
-                for (auto &cb : working_callbacks_) {
-                    try {
-                        PerformCallback(cb);
-                    } catch (const std::exception &ex) {
-                        LOG_ERROR("Caught exception during callback: " << ex.what());
-                    } catch (...) {
-                        LOG_ERROR("Caught unknown exception during callback");
-                    }
-                }
-                working_callbacks_.clear();
-            }
-            handling_callbacks_ = false;
-        }
-    }
-
-    template <class OrderPtr>
-    void OrderBook<OrderPtr>::PerformCallback(TypedCallback &cb) {
-        switch (cb.type_) {
-            case TypedCallback::CbType::CB_ORDER_FILL: {
-                Cost fill_cost      = cb.price_ * cb.quantity_;
-                bool inbound_filled = (cb.flags_ & (TypedCallback::FillFlags::FF_INBOUND_FILLED |
-                                                    TypedCallback::FillFlags::FF_BOTH_FILLED)) != 0;
-                bool matched_filled = (cb.flags_ & (TypedCallback::FillFlags::FF_MATCHED_FILLED |
-                                                    TypedCallback::FillFlags::FF_BOTH_FILLED)) != 0;
-                // generate new trade id
-                static FillId fill_id{0};
-                ++fill_id;
-                OnFill(cb.order_, cb.matched_order_, cb.quantity_, fill_cost, fill_id);
-                OrderId buy_order_id, sell_order_id;
-                if (cb.matched_order_->IsBuy()) {
-                    buy_order_id  = cb.matched_order_->GetOrderId();
-                    sell_order_id = cb.order_->GetOrderId();
-                } else {
-                    buy_order_id  = cb.order_->GetOrderId();
-                    sell_order_id = cb.matched_order_->GetOrderId();
-                }
-                bool buyer_maker = cb.matched_order_->IsBuy() ? true : false;
-                OnTrade(this, buy_order_id, sell_order_id, cb.quantity_, cb.price_, buyer_maker);
-                break;
-            }
-            case TypedCallback::CbType::CB_ORDER_ACCEPT:
-                OnAccept(cb.order_, cb.quantity_);
-                break;
-            case TypedCallback::CbType::CB_ORDER_REJECT:
-                OnReject(cb.order_, cb.reject_reason_);
-                break;
-            case TypedCallback::CbType::CB_ORDER_CANCEL:
-                OnCancel(cb.order_, cb.quantity_);
-                break;
-            case TypedCallback::CbType::CB_ORDER_CANCEL_REJECT:
-                OnCancelReject(cb.order_, cb.reject_reason_);
-                break;
-            case TypedCallback::CbType::CB_ORDER_REPLACE:
-                OnReplace(cb.order_, cb.quantity_, cb.quantity_ + cb.delta_, cb.price_);
-                break;
-            case TypedCallback::CbType::CB_ORDER_REPLACE_REJECT:
-                OnReplaceReject(cb.order_, cb.reject_reason_);
-                break;
-            case TypedCallback::CbType::CB_BOOK_UPDATE:
-                OnOrderBookChange();
-                break;
-            case TypedCallback::CbType::CB_SL_TRIGGERED:
-                OnStopLossTriggered(cb.order_id_);
+    template <class OrderPtr, class Listener>
+    auto OrderBook<OrderPtr, Listener>::LevelOrders(bool buy_side, Price price) const -> uint32_t {
+        const PriceLevel *level = (buy_side ? bids_ : asks_).Level(price);
+        return level ? level->count_ : 0;
+    }
+
+    template <class OrderPtr, class Listener>
+    auto OrderBook<OrderPtr, Listener>::TopLevels(bool buy_side, std::size_t depth, LevelView *out) const
+            -> std::size_t {
+        const TrackerLadder &side  = buy_side ? bids_ : asks_;
+        std::size_t          count = 0;
+        Price                price = side.BestPrice();
+        while (count < depth && price != INVALID_LEVEL_PRICE) {
+            const PriceLevel *level = side.Level(price);
+            out[count++]            = LevelView{price, level->quantity_, level->count_};
+            if (!side.NextLevel(price, price)) {
                 break;
-            default: {
-                std::stringstream msg;
-                msg << "Unexpected callback type " << cb.type_;
-                throw std::runtime_error(msg.str());
             }
         }
+        return count;
+    }
+
+    template <class OrderPtr, class Listener>
+    auto OrderBook<OrderPtr, Listener>::CallbackNow() -> void {
+        LATENCY_START(callback);
+        // A level touched by several operations since the last flush is published once
+        if (dirty_.size() > 1) {
+            std::sort(dirty_.begin(), dirty_.end());
+            dirty_.erase(std::unique(dirty_.begin(), dirty_.end()), dirty_.end());
+        }
+        listener_.Flush(*this);
+        LATENCY_RECORD(perf::Probe::CALLBACK, callback);
+        // Every update queued so far has been handled, the levels behind them are published
+        dirty_.clear();
     }
 
-    template <class OrderPtr>
-    void OrderBook<OrderPtr>::Log() const {
-        LOG_INFO("Symbol " << symbol_);
-        LOG_INFO("Market Price " << market_price_);
+    template <class OrderPtr, class Listener>
+    auto OrderBook<OrderPtr, Listener>::SetAutoFlush(bool auto_flush) -> void {
+        auto_flush_ = auto_flush;
+    }
+
+    template <class OrderPtr, class Listener>
+    auto OrderBook<OrderPtr, Listener>::AutoFlush() const -> bool {
+        return auto_flush_;
+    }
+
+    template <class OrderPtr, class Listener>
+    auto OrderBook<OrderPtr, Listener>::GetListener() -> Listener & {
+        return listener_;
+    }
+
+    template <class OrderPtr, class Listener>
+    void OrderBook<OrderPtr, Listener>::Log() const {
+        LOG_INFO("Symbol {}", symbol_);
+        LOG_INFO("Market Price {}", market_price_);
         for (auto ask = asks_.rbegin(); ask != asks_.rend(); ++ask) {
-            LOG_INFO("  Ask " << ask->second.OpenQty() << " @ " << ask->first);
+            LOG_INFO("  Ask {} @ {}", ask->tracker_.OpenQty(), ask->price_);
         }
 
         for (auto bid = bids_.begin(); bid != bids_.end(); ++bid) {
-            LOG_INFO("  Bid " << bid->second.OpenQty() << " @ " << bid->first);
+            LOG_INFO("  Bid {} @ {}", bid->tracker_.OpenQty(), bid->price_);
+        }
+    }
+
+    template <class OrderPtr, class Listener>
+    auto OrderBook<OrderPtr, Listener>::Save(SnapshotWriter &writer) const -> void {
+        writer.Write(BookSnapshot{symbol_, market_price_, listener_.GetFillId(), bids_.size(), asks_.size(),
+                                  buy_stops_.size() + sell_stops_.size(), auction_});
+        for (const TrackerLadder *side : {&bids_, &asks_, &buy_stops_, &sell_stops_}) {
+            for (const auto &entry : *side) {
+                const auto &order = entry.tracker_.Ptr();
+                writer.Write(RestingOrder{order->GetOrderId(), order->OrderQty(), order->GetPrice(),
+                                          entry.tracker_.OpenQty(), order->QuantityFilled(), order->FillCost(),
+                                          order->IsTriggered() ? 0 : order->GetStopPrice(), order->GetOwner(),
+                                          order->IsBuy(), order->IsPostOnly(), order->GetTimeInForce()});
+            }
+        }
+    }
+
+    template <class OrderPtr, class Listener>
+    auto OrderBook<OrderPtr, Listener>::Restore(const BookSnapshot &snapshot) -> void {
+        symbol_       = snapshot.symbol_;
+        market_price_ = snapshot.market_price_;
+        auction_      = snapshot.auction_;
+        listener_.SetFillId(snapshot.fill_id_);
+    }
+
+    template <class OrderPtr, class Listener>
+    auto OrderBook<OrderPtr, Listener>::Restore(const OrderPtr &order) -> void {
+        Tracker tracker(order);
+        tracker.Fill(order->OrderQty() - order->QuantityOnMarket());
+        if (order->IsStop() && !order->IsTriggered()) {
+            TrackerLadder &stops = order->IsBuy() ? buy_stops_ : sell_stops_;
+            order->SetBookHandle(stops.Insert(tracker, order->GetStopPrice()));
+            return;
         }
+        TrackerLadder &side = order->IsBuy() ? bids_ : asks_;
+        order->SetBookHandle(side.Insert(tracker, order->GetPrice()));
     }
 }    // namespace lhft::book
\ No newline at end of file
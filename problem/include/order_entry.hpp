@@ -0,0 +1,126 @@
+#pragma once
+
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "command.hpp"
+#include "latency.hpp"
+#include "types.hpp"
+
+namespace lhft::me {
+    // Binary order entry: every message is a fixed layout, packed, little endian record that starts
+    // with its own length, so a stream of them needs no other framing and unknown messages can be
+    // stepped over.
+    static_assert(std::endian::native == std::endian::little, "order entry messages are read in place");
+
+    enum class MessageType : uint8_t { ADD_ORDER = 'A', CANCEL_ORDER = 'X', REPLACE_ORDER = 'U', MASS_CANCEL = 'M' };
+
+    enum class OrderType : uint8_t { LIMIT = 0, MARKET = 1 };
+
+    enum class Side : uint8_t { BUY = 'B', SELL = 'S', BOTH = '*' };    // BOTH only for mass cancels
+
+#pragma pack(push, 1)
+    struct MessageHeader {
+        uint16_t    length_{0};    // whole message, header included
+        MessageType type_{};
+    };
+
+    struct AddOrderMessage {
+        MessageHeader     header_{sizeof(AddOrderMessage), MessageType::ADD_ORDER};
+        uint64_t          order_id_{0};
+        uint32_t          symbol_{0};
+        uint64_t          price_{0};    // ignored for market orders
+        uint32_t          quantity_{0};
+        Side              side_{};
+        OrderType         order_type_{};
+        book::TimeInForce time_in_force_{};
+        bool              post_only_{};
+        uint64_t          stop_price_{0};    // 0 unless the order waits for its stop
+        uint32_t          owner_{0};         // session or account mass cancels go by, 0 for none
+    };
+
+    struct CancelOrderMessage {
+        MessageHeader header_{sizeof(CancelOrderMessage), MessageType::CANCEL_ORDER};
+        uint64_t      order_id_{0};
+        uint32_t      symbol_{0};
+    };
+
+    struct ReplaceOrderMessage {
+        MessageHeader header_{sizeof(ReplaceOrderMessage), MessageType::REPLACE_ORDER};
+        uint64_t      order_id_{0};
+        uint32_t      symbol_{0};
+        uint64_t      price_{0};
+        uint32_t      quantity_{0};
+    };
+
+    struct MassCancelMessage {
+        MessageHeader header_{sizeof(MassCancelMessage), MessageType::MASS_CANCEL};
+        uint32_t      symbol_{0};
+        Side          side_{Side::BOTH};
+        uint32_t      owner_{0};    // 0 takes the orders of every owner
+    };
+#pragma pack(pop)
+
+    static_assert(sizeof(AddOrderMessage) == 43);
+    static_assert(sizeof(CancelOrderMessage) == 15);
+    static_assert(sizeof(ReplaceOrderMessage) == 27);
+    static_assert(sizeof(MassCancelMessage) == 12);
+
+    // Appends messages to a send buffer
+    class MessageEncoder {
+    public:
+        auto AddOrder(uint64_t order_id, Side side, uint32_t symbol, uint32_t quantity, uint64_t price,
+                      OrderType order_type = OrderType::LIMIT, book::TimeInForce time_in_force = book::TimeInForce::GTC,
+                      bool post_only = false, uint64_t stop_price = 0, uint32_t owner = 0) -> void;
+
+        auto CancelOrder(uint64_t order_id, uint32_t symbol) -> void;
+
+        auto ReplaceOrder(uint64_t order_id, uint32_t symbol, uint32_t quantity, uint64_t price) -> void;
+
+        auto MassCancel(uint32_t symbol, Side side = Side::BOTH, uint32_t owner = 0) -> void;
+
+        [[nodiscard]] auto Data() const -> const std::byte *;
+
+        [[nodiscard]] auto Size() const -> std::size_t;
+
+        auto Clear() -> void;
+
+    private:
+        template <typename Message>
+        auto Append(const Message &message) -> void;
+
+        std::vector<std::byte> buffer_{};
+    };
+
+    // Turns the messages of a receive buffer into Commands, reading each field where it lies.
+    // Only complete messages are consumed, a message cut at the end of the buffer is left for the
+    // next call once the rest of it has arrived. Unknown or malformed messages are skipped and
+    // counted; a length too short to step over ends the stream.
+    class MessageDecoder {
+    public:
+        // Hands a Command for every complete message to handler, returns the bytes consumed
+        template <typename Handler>
+        auto Decode(const std::byte *data, std::size_t size, Handler &&handler) -> std::size_t;
+
+        [[nodiscard]] auto Errors() const -> std::size_t;
+
+        // Set once a message length made the stream unreadable
+        [[nodiscard]] auto Broken() const -> bool;
+
+    private:
+        [[nodiscard]] auto ToCommand(const std::byte *message, MessageType type, std::size_t length,
+                                     Command &command) const -> bool;
+
+        std::size_t errors_{0};
+        bool        broken_{false};
+    };
+
+    // Decodes data and applies every message to market, batch messages at a time
+    template <typename Market>
+    auto Dispatch(MessageDecoder &decoder, const std::byte *data, std::size_t size, Market &market,
+                  std::size_t batch = book::COMMAND_BATCH_SIZE) -> std::size_t;
+}    // namespace lhft::me
+
+#include "order_entry.inl"
@@ -0,0 +1,56 @@
+#include <cstring>
+
+namespace lhft::me {
+    template <typename Message>
+    auto MessageEncoder::Append(const Message &message) -> void {
+        std::size_t offset = buffer_.size();
+        buffer_.resize(offset + sizeof(Message));
+        std::memcpy(buffer_.data() + offset, &message, sizeof(Message));
+    }
+
+    template <typename Handler>
+    auto MessageDecoder::Decode(const std::byte *data, std::size_t size, Handler &&handler) -> std::size_t {
+        std::size_t offset = 0;
+        while (!broken_ && size - offset >= sizeof(MessageHeader)) {
+            MessageHeader header;
+            std::memcpy(&header, data + offset, sizeof(header));
+            if (header.length_ < sizeof(MessageHeader)) {
+                // Nothing to step over, the rest of the stream can't be framed
+                ++errors_;
+                broken_ = true;
+                break;
+            }
+            if (size - offset < header.length_) {
+                break;
+            }
+            Command command;
+            LATENCY_START(decode);
+            bool decoded = ToCommand(data + offset, header.type_, header.length_, command);
+            LATENCY_RECORD(perf::Probe::DECODE, decode);
+            if (decoded) {
+                handler(command);
+            } else {
+                ++errors_;
+            }
+            offset += header.length_;
+        }
+        return offset;
+    }
+
+    template <typename Market>
+    auto Dispatch(MessageDecoder &decoder, const std::byte *data, std::size_t size, Market &market,
+                  std::size_t batch) -> std::size_t {
+        std::size_t applied = 0;
+        batch               = batch ? batch : 1;
+        market.BeginBatch();
+        std::size_t consumed = decoder.Decode(data, size, [&](const Command &command) {
+            market.Apply(command);
+            if (++applied % batch == 0) {
+                market.EndBatch();
+                market.BeginBatch();
+            }
+        });
+        market.EndBatch();
+        return consumed;
+    }
+}    // namespace lhft::me
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+#include "command.hpp"
+#include "types.hpp"
+
+namespace lhft::me {
+    // Read only memory map of a whole file, pages are read ahead sequentially by the kernel
+    class MappedFile {
+    public:
+        MappedFile() = default;
+
+        MappedFile(const MappedFile &) = delete;
+
+        auto operator=(const MappedFile &) -> MappedFile & = delete;
+
+        ~MappedFile();
+
+        auto Open(const std::string &file_name) -> bool;
+
+        auto Close() -> void;
+
+        [[nodiscard]] auto IsOpen() const -> bool;
+
+        [[nodiscard]] auto Data() const -> std::string_view;
+
+    private:
+        const char *base_{nullptr};
+        std::size_t length_{0};
+    };
+
+    // Parses order lines straight out of a buffer, without copies or locale aware conversions:
+    //   A,<order id>,<B|S>,<quantity>,<price>[,<symbol>]
+    //   X,<order id>[,...]
+    // Submits without a symbol go to default_symbol. Blank lines are skipped, malformed ones are
+    // skipped and counted.
+    class OrderFileParser {
+    public:
+        explicit OrderFileParser(std::string_view data, book::Symbol default_symbol = book::DEFAULT_SYMBOL);
+
+        // False once the data is exhausted
+        auto Next(Command &command) -> bool;
+
+        // Fills up to max commands, returns how many were parsed, 0 at the end of the data
+        auto Next(Command *commands, std::size_t max) -> std::size_t;
+
+        [[nodiscard]] auto Lines() const -> std::size_t;
+
+        [[nodiscard]] auto Errors() const -> std::size_t;
+
+    private:
+        auto ParseLine(const char *pos, const char *end, Command &command) const -> bool;
+
+        const char * pos_;
+        const char * end_;
+        book::Symbol default_symbol_;
+        std::size_t  lines_{0};
+        std::size_t  errors_{0};
+    };
+}    // namespace lhft::me
@@ -0,0 +1,69 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+#include "types.hpp"
+
+namespace lhft::me {
+    // Flat open-addressing map from order id to Value. Linear probing over a power-of-two table sized
+    // for the preallocated capacity keeps a lookup to one cache line and inserts/erases off the heap.
+    // Erase shifts the following cluster back instead of leaving tombstones, so the table does not
+    // degrade under the constant add/remove churn of a live book. Optionally, ids inside
+    // [dense_base, dense_base + dense_size) bypass hashing and index a plain array directly.
+    template <typename Value>
+    class OrderIndex {
+    public:
+        using OrderId = book::OrderId;
+
+        explicit OrderIndex(std::size_t capacity = book::ORDER_INDEX_CAPACITY, OrderId dense_base = 0,
+                            std::size_t dense_size = 0);
+
+        [[nodiscard]] auto Find(OrderId order_id) -> Value *;
+
+        [[nodiscard]] auto Find(OrderId order_id) const -> const Value *;
+
+        auto Insert(OrderId order_id, const Value &value) -> bool;
+
+        auto Erase(OrderId order_id) -> bool;
+
+        auto Clear() -> void;
+
+        // Rehashes once so that size entries fit without further growth
+        auto Reserve(std::size_t size) -> void;
+
+        template <typename Function>
+        auto ForEach(Function &&function) const -> void;
+
+        [[nodiscard]] auto Size() const -> std::size_t;
+
+        [[nodiscard]] auto Empty() const -> bool;
+
+        [[nodiscard]] auto Capacity() const -> std::size_t;
+
+    private:
+        struct Slot {
+            OrderId key_{0};
+            Value   value_{};
+            bool    used_{false};
+        };
+
+        [[nodiscard]] auto IsDense(OrderId order_id) const -> bool;
+
+        [[nodiscard]] auto Home(OrderId order_id) const -> std::size_t;
+
+        [[nodiscard]] auto Probe(OrderId order_id) const -> std::size_t;
+
+        auto Rehash(std::size_t slots) -> void;
+
+        std::vector<Slot> slots_{};
+        std::size_t       mask_{0};
+        std::size_t       shift_{0};
+        std::size_t       size_{0};
+        std::vector<Slot> dense_{};
+        OrderId           dense_base_{0};
+        std::size_t       dense_used_{0};
+    };
+}    // namespace lhft::me
+
+#include "order_index.inl"
@@ -0,0 +1,160 @@
+#include <bit>
+#include <utility>
+
+namespace lhft::me {
+    template <typename Value>
+    OrderIndex<Value>::OrderIndex(std::size_t capacity, OrderId dense_base, std::size_t dense_size)
+        : dense_(dense_size), dense_base_(dense_base) {
+        // Keep the load factor at or below one half for the whole preallocated capacity
+        Rehash(std::bit_ceil((capacity ? capacity : 1) * 2));
+    }
+
+    template <typename Value>
+    auto OrderIndex<Value>::Find(OrderId order_id) -> Value * {
+        return const_cast<Value *>(static_cast<const OrderIndex *>(this)->Find(order_id));
+    }
+
+    template <typename Value>
+    auto OrderIndex<Value>::Find(OrderId order_id) const -> const Value * {
+        if (IsDense(order_id)) {
+            const Slot &slot = dense_[order_id - dense_base_];
+            return slot.used_ ? &slot.value_ : nullptr;
+        }
+        const Slot &slot = slots_[Probe(order_id)];
+        return slot.used_ ? &slot.value_ : nullptr;
+    }
+
+    template <typename Value>
+    auto OrderIndex<Value>::Insert(OrderId order_id, const Value &value) -> bool {
+        if (IsDense(order_id)) {
+            Slot &slot = dense_[order_id - dense_base_];
+            if (slot.used_) {
+                return false;
+            }
+            slot = Slot{order_id, value, true};
+            ++dense_used_;
+            return true;
+        }
+        std::size_t index = Probe(order_id);
+        if (slots_[index].used_) {
+            return false;
+        }
+        if ((size_ + 1) * 2 > slots_.size()) {
+            Rehash(slots_.size() * 2);
+            index = Probe(order_id);
+        }
+        slots_[index] = Slot{order_id, value, true};
+        ++size_;
+        return true;
+    }
+
+    template <typename Value>
+    auto OrderIndex<Value>::Erase(OrderId order_id) -> bool {
+        if (IsDense(order_id)) {
+            Slot &slot = dense_[order_id - dense_base_];
+            if (!slot.used_) {
+                return false;
+            }
+            slot = Slot{};
+            --dense_used_;
+            return true;
+        }
+        std::size_t hole = Probe(order_id);
+        if (!slots_[hole].used_) {
+            return false;
+        }
+        // Backward shift: pull up every entry of the cluster whose home is not between the hole and itself
+        for (std::size_t next = (hole + 1) & mask_; slots_[next].used_; next = (next + 1) & mask_) {
+            std::size_t home = Home(slots_[next].key_);
+            if (((next - home) & mask_) >= ((next - hole) & mask_)) {
+                slots_[hole] = std::move(slots_[next]);
+                hole         = next;
+            }
+        }
+        slots_[hole] = Slot{};
+        --size_;
+        return true;
+    }
+
+    template <typename Value>
+    auto OrderIndex<Value>::Clear() -> void {
+        for (auto &slot : slots_) {
+            slot = Slot{};
+        }
+        for (auto &slot : dense_) {
+            slot = Slot{};
+        }
+        size_       = 0;
+        dense_used_ = 0;
+    }
+
+    template <typename Value>
+    auto OrderIndex<Value>::Reserve(std::size_t size) -> void {
+        if (size * 2 > slots_.size()) {
+            Rehash(std::bit_ceil(size * 2));
+        }
+    }
+
+    template <typename Value>
+    template <typename Function>
+    auto OrderIndex<Value>::ForEach(Function &&function) const -> void {
+        for (const auto &slot : dense_) {
+            if (slot.used_) {
+                function(slot.key_, slot.value_);
+            }
+        }
+        for (const auto &slot : slots_) {
+            if (slot.used_) {
+                function(slot.key_, slot.value_);
+            }
+        }
+    }
+
+    template <typename Value>
+    auto OrderIndex<Value>::Size() const -> std::size_t {
+        return size_ + dense_used_;
+    }
+
+    template <typename Value>
+    auto OrderIndex<Value>::Empty() const -> bool {
+        return Size() == 0;
+    }
+
+    template <typename Value>
+    auto OrderIndex<Value>::Capacity() const -> std::size_t {
+        return slots_.size() / 2 + dense_.size();
+    }
+
+    template <typename Value>
+    auto OrderIndex<Value>::IsDense(OrderId order_id) const -> bool {
+        return order_id - dense_base_ < dense_.size();
+    }
+
+    template <typename Value>
+    auto OrderIndex<Value>::Home(OrderId order_id) const -> std::size_t {
+        // Fibonacci hashing spreads both sequential and strided ids over the whole table
+        return (order_id * 0x9E3779B97F4A7C15ULL) >> shift_;
+    }
+
+    template <typename Value>
+    auto OrderIndex<Value>::Probe(OrderId order_id) const -> std::size_t {
+        std::size_t index = Home(order_id);
+        while (slots_[index].used_ && slots_[index].key_ != order_id) {
+            index = (index + 1) & mask_;
+        }
+        return index;
+    }
+
+    template <typename Value>
+    auto OrderIndex<Value>::Rehash(std::size_t slots) -> void {
+        std::vector<Slot> old(slots);
+        old.swap(slots_);
+        mask_  = slots - 1;
+        shift_ = 64 - std::countr_zero(slots);
+        for (auto &slot : old) {
+            if (slot.used_) {
+                slots_[Probe(slot.key_)] = std::move(slot);
+            }
+        }
+    }
+}    // namespace lhft::me
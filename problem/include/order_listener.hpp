@@ -0,0 +1,115 @@
+#pragma once
+
+#include <vector>
+
+#include "callback.hpp"
+#include "logger.hpp"
+#include "order.hpp"
+#include "trade_tape.hpp"
+#include "types.hpp"
+
+namespace lhft::book {
+    // Default OrderBook listener. Every event is applied to the orders and logged as soon as the
+    // book raises it, nothing is queued. Fill ids are numbered per book, so books driven from
+    // different threads never share a counter.
+    template <typename OrderPtr>
+    class OrderListener {
+    public:
+        auto OnAccept(const OrderPtr &order) -> void;
+
+        auto OnReject(const OrderPtr &order, const char *reason) -> void;
+
+        auto OnFill(const OrderPtr &order, const OrderPtr &matched_order, Quantity fill_qty, Price fill_price,
+                    FillFlags fill_flags) -> void;
+
+        auto OnCancel(const OrderPtr &order, Quantity open_qty) -> void;
+
+        auto OnCancelReject(const OrderPtr &order, const char *reason) -> void;
+
+        // One event for every order a mass cancel took off the book
+        auto OnMassCancel(const std::vector<OrderPtr> &orders) -> void;
+
+        auto OnReplace(const OrderPtr &order, Quantity current_qty, int64_t size_delta, Price new_price) -> void;
+
+        auto OnReplaceReject(const OrderPtr &order, const char *reason) -> void;
+
+        template <typename Book>
+        auto OnBookUpdate(const Book &book) -> void;
+
+        auto OnStopLossTriggered(const OrderId &order_id) -> void;
+
+        template <typename Book>
+        auto Flush(const Book &book) -> void;
+
+        // Every trade is appended to tape, which may be shared by the books of one matching thread
+        auto SetTradeTape(TradeTape *tape) -> void;
+
+        // Fill ids are counted per book, so two books, in one shard or not, hand out the same ids. A
+        // fill is identified by its symbol and fill id together
+        [[nodiscard]] auto GetFillId() const -> FillId;
+
+        auto SetFillId(FillId fill_id) -> void;
+
+    protected:
+        auto OnTrade(Symbol symbol, const OrderId &buyer_id, const OrderId &seller_id, Quantity qty, Price price,
+                     bool buyer_maker, FillId fill_id) -> void;
+
+    private:
+        FillId     fill_id_{0};
+        TradeTape *trade_tape_{nullptr};
+    };
+
+    // Keeps the original deferred behaviour: events are materialized as Callback records and only
+    // dispatched to Handler when the book flushes, each one guarded by its own try/catch.
+    template <typename OrderPtr, typename Handler = OrderListener<OrderPtr>>
+    class DeferredListener {
+    public:
+        using TypedCallback = Callback<OrderPtr>;
+        using Callbacks     = std::vector<TypedCallback>;
+
+        DeferredListener();
+
+        auto OnAccept(const OrderPtr &order) -> void;
+
+        auto OnReject(const OrderPtr &order, const char *reason) -> void;
+
+        auto OnFill(const OrderPtr &order, const OrderPtr &matched_order, Quantity fill_qty, Price fill_price,
+                    FillFlags fill_flags) -> void;
+
+        auto OnCancel(const OrderPtr &order, Quantity open_qty) -> void;
+
+        auto OnCancelReject(const OrderPtr &order, const char *reason) -> void;
+
+        // One event for every order a mass cancel took off the book
+        auto OnMassCancel(const std::vector<OrderPtr> &orders) -> void;
+
+        auto OnReplace(const OrderPtr &order, Quantity current_qty, int64_t size_delta, Price new_price) -> void;
+
+        auto OnReplaceReject(const OrderPtr &order, const char *reason) -> void;
+
+        template <typename Book>
+        auto OnBookUpdate(const Book &book) -> void;
+
+        auto OnStopLossTriggered(const OrderId &order_id) -> void;
+
+        template <typename Book>
+        auto Flush(const Book &book) -> void;
+
+        template <typename Book>
+        auto PerformCallback(const Book &book, TypedCallback &cb) -> void;
+
+        auto GetHandler() -> Handler &;
+
+        [[nodiscard]] auto GetFillId() const -> FillId;
+
+        auto SetFillId(FillId fill_id) -> void;
+
+    private:
+        Handler   handler_{};
+        Callbacks callbacks_{};
+        Callbacks working_callbacks_{};
+        bool      handling_callbacks_{false};
+    };
+}    // namespace lhft::book
+
+#include "order_listener.inl"
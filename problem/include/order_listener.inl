@@ -0,0 +1,259 @@
+#include <sstream>
+
+namespace lhft::book {
+    template <typename OrderPtr>
+    auto OrderListener<OrderPtr>::OnAccept(const OrderPtr &order) -> void {
+        order->OnAccepted();
+        LOG_INFO("Event: Accepted: {}", OrderSnapshot(*order));
+    }
+
+    template <typename OrderPtr>
+    auto OrderListener<OrderPtr>::OnReject(const OrderPtr &order, const char *reason) -> void {
+        order->OnRejected(reason);
+        LOG_INFO("Event: Rejected: {} {}", OrderSnapshot(*order), reason);
+    }
+
+    template <typename OrderPtr>
+    auto OrderListener<OrderPtr>::OnFill(const OrderPtr &order, const OrderPtr &matched_order, Quantity fill_qty,
+                                         Price fill_price, FillFlags) -> void {
+        Cost fill_cost = fill_price * fill_qty;
+        // generate new trade id
+        FillId fill_id = ++fill_id_;
+
+        order->OnFilled(fill_qty, fill_cost);
+        matched_order->OnFilled(fill_qty, fill_cost);
+
+        LOG_INFO("Event: Fill-{}: {} Shares for {} {} {}: {} Shares for {} {}", order->IsBuy() ? "Bought" : "Sold",
+                 fill_qty, fill_cost, OrderSnapshot(*order), matched_order->IsBuy() ? "Bought" : "Sold", fill_qty,
+                 fill_cost, OrderSnapshot(*matched_order));
+
+        order->AddTradeHistory(fill_qty, matched_order->QuantityOnMarket(), fill_cost, matched_order->GetOrderId(),
+                               matched_order->GetPrice(), fill_id);
+        matched_order->AddTradeHistory(fill_qty, order->QuantityOnMarket(), fill_cost, order->GetOrderId(),
+                                       order->GetPrice(), fill_id);
+
+        OrderId buy_order_id, sell_order_id;
+        if (matched_order->IsBuy()) {
+            buy_order_id  = matched_order->GetOrderId();
+            sell_order_id = order->GetOrderId();
+        } else {
+            buy_order_id  = order->GetOrderId();
+            sell_order_id = matched_order->GetOrderId();
+        }
+        bool buyer_maker = matched_order->IsBuy();
+        OnTrade(order->GetSymbol(), buy_order_id, sell_order_id, fill_qty, fill_price, buyer_maker, fill_id);
+    }
+
+    template <typename OrderPtr>
+    auto OrderListener<OrderPtr>::OnCancel(const OrderPtr &order, Quantity) -> void {
+        order->OnCancelled();
+        LOG_INFO("Event: Canceled: {}", OrderSnapshot(*order));
+    }
+
+    template <typename OrderPtr>
+    auto OrderListener<OrderPtr>::OnMassCancel(const std::vector<OrderPtr> &orders) -> void {
+        for (const auto &order : orders) {
+            order->OnCancelled();
+        }
+        LOG_INFO("Event: Mass cancel: {} orders", orders.size());
+    }
+
+    template <typename OrderPtr>
+    auto OrderListener<OrderPtr>::OnCancelReject(const OrderPtr &order, const char *reason) -> void {
+        order->OnCancelRejected(reason);
+        LOG_INFO("Event: Cancel Reject: {} {}", OrderSnapshot(*order), reason);
+    }
+
+    template <typename OrderPtr>
+    auto OrderListener<OrderPtr>::OnReplace(const OrderPtr &order, Quantity current_qty, int64_t size_delta,
+                                            Price new_price) -> void {
+        order->OnReplaced(size_delta, new_price);
+        LOG_INFO("Event: Replaced: {} was open {}", OrderSnapshot(*order), current_qty);
+    }
+
+    template <typename OrderPtr>
+    auto OrderListener<OrderPtr>::OnReplaceReject(const OrderPtr &order, const char *reason) -> void {
+        order->OnReplaceRejected(reason);
+        LOG_INFO("Event: Replace Reject: {} {}", OrderSnapshot(*order), reason);
+    }
+
+    template <typename OrderPtr>
+    template <typename Book>
+    auto OrderListener<OrderPtr>::OnBookUpdate(const Book &) -> void {
+        // The inline listener publishes no depth, DepthListener does
+    }
+
+    template <typename OrderPtr>
+    auto OrderListener<OrderPtr>::OnStopLossTriggered(const OrderId &order_id) -> void {
+        LOG_INFO("Event: Stop triggered: #{}", order_id);
+    }
+
+    template <typename OrderPtr>
+    template <typename Book>
+    auto OrderListener<OrderPtr>::Flush(const Book &) -> void {
+    }
+
+    template <typename OrderPtr>
+    auto OrderListener<OrderPtr>::SetTradeTape(TradeTape *tape) -> void {
+        trade_tape_ = tape;
+    }
+
+    template <typename OrderPtr>
+    auto OrderListener<OrderPtr>::GetFillId() const -> FillId {
+        return fill_id_;
+    }
+
+    template <typename OrderPtr>
+    auto OrderListener<OrderPtr>::SetFillId(FillId fill_id) -> void {
+        fill_id_ = fill_id;
+    }
+
+    template <typename OrderPtr>
+    auto OrderListener<OrderPtr>::OnTrade(Symbol symbol, const OrderId &buyer_id, const OrderId &seller_id,
+                                          Quantity qty, Price price, bool buyer_maker, FillId fill_id) -> void {
+        if (trade_tape_) {
+            trade_tape_->Append(TradeData{{}, buyer_id, seller_id, symbol, qty, price, buyer_maker, fill_id});
+        }
+    }
+
+    template <typename OrderPtr, typename Handler>
+    DeferredListener<OrderPtr, Handler>::DeferredListener() {
+        callbacks_.reserve(16);
+        working_callbacks_.reserve(callbacks_.capacity());
+    }
+
+    template <typename OrderPtr, typename Handler>
+    auto DeferredListener<OrderPtr, Handler>::OnAccept(const OrderPtr &order) -> void {
+        callbacks_.push_back(TypedCallback::Accept(order));
+    }
+
+    template <typename OrderPtr, typename Handler>
+    auto DeferredListener<OrderPtr, Handler>::OnReject(const OrderPtr &order, const char *reason) -> void {
+        callbacks_.push_back(TypedCallback::Reject(order, reason));
+    }
+
+    template <typename OrderPtr, typename Handler>
+    auto DeferredListener<OrderPtr, Handler>::OnFill(const OrderPtr &order, const OrderPtr &matched_order,
+                                                     Quantity fill_qty, Price fill_price, FillFlags fill_flags)
+            -> void {
+        callbacks_.push_back(TypedCallback::Fill(order, matched_order, fill_qty, fill_price, fill_flags));
+    }
+
+    template <typename OrderPtr, typename Handler>
+    auto DeferredListener<OrderPtr, Handler>::OnCancel(const OrderPtr &order, Quantity open_qty) -> void {
+        callbacks_.push_back(TypedCallback::Cancel(order, open_qty));
+    }
+
+    template <typename OrderPtr, typename Handler>
+    auto DeferredListener<OrderPtr, Handler>::OnMassCancel(const std::vector<OrderPtr> &orders) -> void {
+        // The list is the book's and gone by the flush, so it is queued as the single cancels it holds
+        for (const auto &order : orders) {
+            callbacks_.push_back(TypedCallback::Cancel(order, order->QuantityOnMarket()));
+        }
+    }
+
+    template <typename OrderPtr, typename Handler>
+    auto DeferredListener<OrderPtr, Handler>::OnCancelReject(const OrderPtr &order, const char *reason) -> void {
+        callbacks_.push_back(TypedCallback::CancelReject(order, reason));
+    }
+
+    template <typename OrderPtr, typename Handler>
+    auto DeferredListener<OrderPtr, Handler>::OnReplace(const OrderPtr &order, Quantity current_qty,
+                                                        int64_t size_delta, Price new_price) -> void {
+        callbacks_.push_back(TypedCallback::Replace(order, current_qty, size_delta, new_price));
+    }
+
+    template <typename OrderPtr, typename Handler>
+    auto DeferredListener<OrderPtr, Handler>::OnReplaceReject(const OrderPtr &order, const char *reason) -> void {
+        callbacks_.push_back(TypedCallback::ReplaceReject(order, reason));
+    }
+
+    template <typename OrderPtr, typename Handler>
+    template <typename Book>
+    auto DeferredListener<OrderPtr, Handler>::OnBookUpdate(const Book &book) -> void {
+        callbacks_.push_back(TypedCallback::BookUpdate());
+    }
+
+    template <typename OrderPtr, typename Handler>
+    auto DeferredListener<OrderPtr, Handler>::OnStopLossTriggered(const OrderId &order_id) -> void {
+        callbacks_.push_back(TypedCallback::StopLossTriggered(order_id));
+    }
+
+    template <typename OrderPtr, typename Handler>
+    template <typename Book>
+    auto DeferredListener<OrderPtr, Handler>::Flush(const Book &book) -> void {
+        if (!handling_callbacks_) {
+            handling_callbacks_ = true;
+            while (!callbacks_.empty()) {
+                working_callbacks_.reserve(callbacks_.capacity());
+                working_callbacks_.swap(callbacks_);
+                for (auto &cb : working_callbacks_) {
+                    try {
+                        PerformCallback(book, cb);
+                    } catch (const std::exception &ex) {
+                        LOG_ERROR("Caught exception during callback: {}", ex.what());
+                    } catch (...) {
+                        LOG_ERROR("Caught unknown exception during callback");
+                    }
+                }
+                working_callbacks_.clear();
+            }
+            handler_.Flush(book);
+            handling_callbacks_ = false;
+        }
+    }
+
+    template <typename OrderPtr, typename Handler>
+    template <typename Book>
+    auto DeferredListener<OrderPtr, Handler>::PerformCallback(const Book &book, TypedCallback &cb) -> void {
+        switch (cb.type_) {
+            case TypedCallback::CbType::CB_ORDER_FILL:
+                handler_.OnFill(cb.order_, cb.matched_order_, cb.quantity_, cb.price_, FillFlags(cb.flags_));
+                break;
+            case TypedCallback::CbType::CB_ORDER_ACCEPT:
+                handler_.OnAccept(cb.order_);
+                break;
+            case TypedCallback::CbType::CB_ORDER_REJECT:
+                handler_.OnReject(cb.order_, cb.reject_reason_);
+                break;
+            case TypedCallback::CbType::CB_ORDER_CANCEL:
+                handler_.OnCancel(cb.order_, cb.quantity_);
+                break;
+            case TypedCallback::CbType::CB_ORDER_CANCEL_REJECT:
+                handler_.OnCancelReject(cb.order_, cb.reject_reason_);
+                break;
+            case TypedCallback::CbType::CB_ORDER_REPLACE:
+                handler_.OnReplace(cb.order_, cb.quantity_, cb.delta_, cb.price_);
+                break;
+            case TypedCallback::CbType::CB_ORDER_REPLACE_REJECT:
+                handler_.OnReplaceReject(cb.order_, cb.reject_reason_);
+                break;
+            case TypedCallback::CbType::CB_BOOK_UPDATE:
+                handler_.OnBookUpdate(book);
+                break;
+            case TypedCallback::CbType::CB_SL_TRIGGERED:
+                handler_.OnStopLossTriggered(cb.order_id_);
+                break;
+            default: {
+                std::stringstream msg;
+                msg << "Unexpected callback type " << cb.type_;
+                throw std::runtime_error(msg.str());
+            }
+        }
+    }
+
+    template <typename OrderPtr, typename Handler>
+    auto DeferredListener<OrderPtr, Handler>::GetHandler() -> Handler & {
+        return handler_;
+    }
+
+    template <typename OrderPtr, typename Handler>
+    auto DeferredListener<OrderPtr, Handler>::GetFillId() const -> FillId {
+        return handler_.GetFillId();
+    }
+
+    template <typename OrderPtr, typename Handler>
+    auto DeferredListener<OrderPtr, Handler>::SetFillId(FillId fill_id) -> void {
+        handler_.SetFillId(fill_id);
+    }
+}    // namespace lhft::book
@@ -0,0 +1,109 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "types.hpp"
+
+namespace lhft::book {
+    // Non-owning, non-refcounted pointer into an ObjectPool. Copying it is a plain pointer copy,
+    // so it can stand in for std::shared_ptr as the OrderPtr of OrderBook/OrderTracker.
+    template <typename T>
+    class PoolPtr {
+    public:
+        PoolPtr() = default;
+
+        PoolPtr(std::nullptr_t) {
+        }
+
+        explicit PoolPtr(T *ptr) : ptr_(ptr) {
+        }
+
+        auto operator->() const -> T * {
+            return ptr_;
+        }
+
+        auto operator*() const -> T & {
+            return *ptr_;
+        }
+
+        [[nodiscard]] auto get() const -> T * {
+            return ptr_;
+        }
+
+        explicit operator bool() const {
+            return ptr_ != nullptr;
+        }
+
+        auto operator==(const PoolPtr &rhs) const -> bool {
+            return ptr_ == rhs.ptr_;
+        }
+
+        auto operator!=(const PoolPtr &rhs) const -> bool {
+            return ptr_ != rhs.ptr_;
+        }
+
+    private:
+        T *ptr_{nullptr};
+    };
+
+    // Slab allocator handing out PoolPtr. Slots are carved out of chunks that are never moved,
+    // so handed out pointers stay valid while the pool grows. A new chunk is not touched until
+    // its slots are handed out, so reserving a large pool costs no page faults up front.
+    template <typename T>
+    class ObjectPool {
+    public:
+        explicit ObjectPool(std::size_t capacity = ORDER_POOL_CAPACITY);
+
+        ObjectPool(const ObjectPool &) = delete;
+
+        ObjectPool(ObjectPool &&other) noexcept;
+
+        auto operator=(const ObjectPool &) -> ObjectPool & = delete;
+
+        auto operator=(ObjectPool &&other) noexcept -> ObjectPool &;
+
+        ~ObjectPool();
+
+        template <typename... Args>
+        auto Create(Args &&...args) -> PoolPtr<T>;
+
+        auto Destroy(PoolPtr<T> ptr) -> void;
+
+        // Grows the pool once so that it holds at least capacity objects. A growth at least doubles the
+        // pool, so repeated small reserves, one per packet, add few chunks
+        auto Reserve(std::size_t capacity) -> void;
+
+        [[nodiscard]] auto Size() const -> std::size_t;
+
+        [[nodiscard]] auto Capacity() const -> std::size_t;
+
+    private:
+        // Trivially constructible on purpose, see Grow
+        struct Slot {
+            alignas(T) std::byte storage_[sizeof(T)];
+            Slot *next_;
+            bool  live_;
+        };
+
+        struct Chunk {
+            std::unique_ptr<Slot[]> slots_;
+            std::size_t             size_{0};
+            std::size_t             used_{0};    // slots below used_ have been handed out at least once
+        };
+
+        auto Grow(std::size_t count) -> void;
+
+        auto Clear() -> void;
+
+        std::vector<Chunk> chunks_{};
+        Slot *             free_{nullptr};
+        std::size_t        size_{0};
+        std::size_t        capacity_{0};
+    };
+}    // namespace lhft::book
+
+#include "order_pool.inl"
@@ -0,0 +1,121 @@
+#include <new>
+
+namespace lhft::book {
+    template <typename T>
+    ObjectPool<T>::ObjectPool(std::size_t capacity) {
+        Grow(capacity ? capacity : 1);
+    }
+
+    template <typename T>
+    ObjectPool<T>::ObjectPool(ObjectPool &&other) noexcept
+        : chunks_(std::move(other.chunks_)),
+          free_(std::exchange(other.free_, nullptr)),
+          size_(std::exchange(other.size_, 0)),
+          capacity_(std::exchange(other.capacity_, 0)) {
+    }
+
+    template <typename T>
+    auto ObjectPool<T>::operator=(ObjectPool &&other) noexcept -> ObjectPool & {
+        if (this != &other) {
+            Clear();
+            chunks_   = std::move(other.chunks_);
+            free_     = std::exchange(other.free_, nullptr);
+            size_     = std::exchange(other.size_, 0);
+            capacity_ = std::exchange(other.capacity_, 0);
+        }
+        return *this;
+    }
+
+    template <typename T>
+    ObjectPool<T>::~ObjectPool() {
+        Clear();
+    }
+
+    template <typename T>
+    template <typename... Args>
+    auto ObjectPool<T>::Create(Args &&...args) -> PoolPtr<T> {
+        T *ptr = nullptr;
+        if (free_) {
+            Slot *slot  = free_;
+            ptr         = new (slot->storage_) T(std::forward<Args>(args)...);
+            free_       = slot->next_;
+            slot->live_ = true;
+        } else {
+            if (chunks_.empty() || chunks_.back().used_ == chunks_.back().size_) {
+                // Double the pool, the existing chunks stay where they are
+                Grow(capacity_ ? capacity_ : 1);
+            }
+            Chunk &chunk = chunks_.back();
+            Slot & slot  = chunk.slots_[chunk.used_];
+            ptr          = new (slot.storage_) T(std::forward<Args>(args)...);
+            slot.live_   = true;
+            ++chunk.used_;
+        }
+        ++size_;
+        return PoolPtr<T>(ptr);
+    }
+
+    template <typename T>
+    auto ObjectPool<T>::Destroy(PoolPtr<T> ptr) -> void {
+        if (!ptr) {
+            return;
+        }
+        ptr->~T();
+        Slot *slot  = reinterpret_cast<Slot *>(ptr.get());
+        slot->live_ = false;
+        slot->next_ = free_;
+        free_       = slot;
+        --size_;
+    }
+
+    template <typename T>
+    auto ObjectPool<T>::Reserve(std::size_t capacity) -> void {
+        if (capacity > capacity_) {
+            Grow(std::max(capacity - capacity_, capacity_));
+        }
+    }
+
+    template <typename T>
+    auto ObjectPool<T>::Size() const -> std::size_t {
+        return size_;
+    }
+
+    template <typename T>
+    auto ObjectPool<T>::Capacity() const -> std::size_t {
+        return capacity_;
+    }
+
+    template <typename T>
+    auto ObjectPool<T>::Grow(std::size_t count) -> void {
+        // Slots the current chunk never handed out move to the free list, so that only the newest
+        // chunk is ever carved from
+        if (!chunks_.empty()) {
+            Chunk &last = chunks_.back();
+            for (std::size_t index = last.size_; index-- > last.used_;) {
+                last.slots_[index].live_ = false;
+                last.slots_[index].next_ = free_;
+                free_                    = &last.slots_[index];
+            }
+            last.used_ = last.size_;
+        }
+        // Left uninitialized, a slot is first written when it is handed out
+        chunks_.push_back(Chunk{std::make_unique_for_overwrite<Slot[]>(count), count, 0});
+        capacity_ += count;
+    }
+
+    template <typename T>
+    auto ObjectPool<T>::Clear() -> void {
+        for (auto &chunk : chunks_) {
+            for (std::size_t index = 0; index < chunk.used_; ++index) {
+                Slot &slot = chunk.slots_[index];
+                if (slot.live_) {
+                    reinterpret_cast<T *>(slot.storage_)->~T();
+                }
+            }
+        }
+        chunks_.clear();
+        free_     = nullptr;
+        size_     = 0;
+        capacity_ = 0;
+    }
+}    // namespace lhft::book
@@ -0,0 +1,206 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <iterator>
+#include <map>
+#include <type_traits>
+#include <vector>
+
+#include "comparable_price.hpp"
+#include "types.hpp"
+
+namespace lhft::book {
+    // count_ and quantity_ are the number of orders and their total open quantity, kept up to date
+    // on every insert, erase and AdjustLevel
+    struct PriceLevel {
+        OrderHandle head_{INVALID_ORDER_HANDLE};
+        OrderHandle tail_{INVALID_ORDER_HANDLE};
+        uint32_t    count_{0};
+        Quantity    quantity_{0};
+    };
+
+    // One side of a book. Price levels within LADDER_TICKS of the anchor live in a dense array
+    // indexed by tick offset, anything further away falls back to an ordered overflow map.
+    // Orders at a level form a FIFO linked through a pooled entry array, so inserting or
+    // unlinking an order never touches the allocator once the pool is warm.
+    template <typename Tracker>
+    class PriceLadder {
+    public:
+        struct Entry {
+            ComparablePrice price_;
+            Tracker         tracker_;
+            OrderHandle     prev_{INVALID_ORDER_HANDLE};
+            OrderHandle     next_{INVALID_ORDER_HANDLE};
+        };
+
+        template <bool CONST>
+        class BasicIterator {
+        public:
+            using iterator_category = std::bidirectional_iterator_tag;
+            using value_type        = Entry;
+            using difference_type   = std::ptrdiff_t;
+            using pointer           = std::conditional_t<CONST, const Entry *, Entry *>;
+            using reference         = std::conditional_t<CONST, const Entry &, Entry &>;
+            using LadderPtr         = std::conditional_t<CONST, const PriceLadder *, PriceLadder *>;
+
+            BasicIterator() = default;
+
+            BasicIterator(LadderPtr ladder, OrderHandle handle) : ladder_(ladder), handle_(handle) {
+            }
+
+            auto operator*() const -> reference {
+                return ladder_->entries_[handle_];
+            }
+
+            auto operator->() const -> pointer {
+                return &ladder_->entries_[handle_];
+            }
+
+            auto operator++() -> BasicIterator & {
+                handle_ = ladder_->Next(handle_);
+                return *this;
+            }
+
+            auto operator++(int) -> BasicIterator {
+                BasicIterator result = *this;
+                ++*this;
+                return result;
+            }
+
+            auto operator--() -> BasicIterator & {
+                handle_ = handle_ == INVALID_ORDER_HANDLE ? ladder_->Back() : ladder_->Prev(handle_);
+                return *this;
+            }
+
+            auto operator--(int) -> BasicIterator {
+                BasicIterator result = *this;
+                --*this;
+                return result;
+            }
+
+            auto operator==(const BasicIterator &rhs) const -> bool {
+                return handle_ == rhs.handle_;
+            }
+
+            auto operator!=(const BasicIterator &rhs) const -> bool {
+                return handle_ != rhs.handle_;
+            }
+
+            [[nodiscard]] auto Handle() const -> OrderHandle {
+                return handle_;
+            }
+
+        private:
+            LadderPtr   ladder_{nullptr};
+            OrderHandle handle_{INVALID_ORDER_HANDLE};
+        };
+
+        using iterator               = BasicIterator<false>;
+        using const_iterator         = BasicIterator<true>;
+        using reverse_iterator       = std::reverse_iterator<iterator>;
+        using const_reverse_iterator = std::reverse_iterator<const_iterator>;
+
+        explicit PriceLadder(bool buy_side, std::size_t ticks = LADDER_TICKS);
+
+        auto Insert(const Tracker &tracker, Price price) -> OrderHandle;
+
+        auto Erase(OrderHandle handle) -> void;
+
+        // Drops every order at once, keeping the storage and the window for the orders to come
+        auto Clear() -> void;
+
+        // A resting tracker changed in place by delta must be reported here, so its level total stays exact
+        auto AdjustLevel(OrderHandle handle, int64_t delta) -> void;
+
+        [[nodiscard]] auto At(OrderHandle handle) -> Entry &;
+
+        [[nodiscard]] auto At(OrderHandle handle) const -> const Entry &;
+
+        [[nodiscard]] auto Front() const -> OrderHandle;
+
+        [[nodiscard]] auto Back() const -> OrderHandle;
+
+        [[nodiscard]] auto Next(OrderHandle handle) const -> OrderHandle;
+
+        [[nodiscard]] auto Prev(OrderHandle handle) const -> OrderHandle;
+
+        [[nodiscard]] auto LevelFront(Price price) const -> OrderHandle;
+
+        [[nodiscard]] auto BestPrice() const -> Price;
+
+        // Aggregate of the level at price, nullptr when nothing rests there. MARKET_ORDER_PRICE is the
+        // level of the resting market orders
+        [[nodiscard]] auto Level(Price price) const -> const PriceLevel *;
+
+        // Nearest occupied level behind price, false past the last one
+        [[nodiscard]] auto NextLevel(Price price, Price &result) const -> bool;
+
+        [[nodiscard]] auto size() const -> std::size_t;
+
+        [[nodiscard]] auto empty() const -> bool;
+
+        auto begin() -> iterator;
+
+        auto end() -> iterator;
+
+        auto begin() const -> const_iterator;
+
+        auto end() const -> const_iterator;
+
+        auto rbegin() -> reverse_iterator;
+
+        auto rend() -> reverse_iterator;
+
+        auto rbegin() const -> const_reverse_iterator;
+
+        auto rend() const -> const_reverse_iterator;
+
+    private:
+        using Overflow = std::map<Price, PriceLevel>;
+
+        [[nodiscard]] auto Better(Price lhs, Price rhs) const -> bool;
+
+        [[nodiscard]] auto InWindow(Price price) const -> bool;
+
+        [[nodiscard]] auto FindLevel(Price price) -> PriceLevel *;
+
+        [[nodiscard]] auto FindLevel(Price price) const -> const PriceLevel *;
+
+        [[nodiscard]] auto WorseLevel(Price price, Price &result) const -> bool;
+
+        [[nodiscard]] auto BetterLevel(Price price, Price &result) const -> bool;
+
+        [[nodiscard]] auto WorstLevel(Price &result) const -> bool;
+
+        [[nodiscard]] auto ScanDown(std::size_t from) const -> std::size_t;
+
+        [[nodiscard]] auto ScanUp(std::size_t from) const -> std::size_t;
+
+        auto Rebase(Price price) -> void;
+
+        auto MarkLevel(std::size_t index, bool occupied) -> void;
+
+        auto Allocate(const Tracker &tracker, Price price) -> OrderHandle;
+
+        auto Release(OrderHandle handle) -> void;
+
+        auto Append(PriceLevel &level, OrderHandle handle) -> void;
+
+        auto Unlink(PriceLevel &level, OrderHandle handle) -> void;
+
+        bool                    buy_side_;
+        std::vector<Entry>      entries_{};
+        OrderHandle             free_{INVALID_ORDER_HANDLE};
+        PriceLevel              market_{};
+        std::vector<PriceLevel> levels_;
+        std::vector<uint64_t>   occupied_;
+        Price                   base_{0};
+        std::size_t             window_levels_{0};
+        Overflow                overflow_{};
+        Price                   best_{INVALID_LEVEL_PRICE};
+        std::size_t             size_{0};
+    };
+}    // namespace lhft::book
+
+#include "price_ladder.inl"
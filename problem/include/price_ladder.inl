@@ -0,0 +1,460 @@
+#include <bit>
+
+namespace lhft::book {
+    template <typename Tracker>
+    PriceLadder<Tracker>::PriceLadder(bool buy_side, std::size_t ticks)
+        : buy_side_(buy_side), levels_((ticks + 63) / 64 * 64), occupied_((ticks + 63) / 64) {
+        entries_.reserve(levels_.size());
+    }
+
+    template <typename Tracker>
+    auto PriceLadder<Tracker>::Insert(const Tracker &tracker, Price price) -> OrderHandle {
+        OrderHandle handle = Allocate(tracker, price);
+        ++size_;
+        if (price == MARKET_ORDER_PRICE) {
+            Append(market_, handle);
+            return handle;
+        }
+        if (!InWindow(price) && (window_levels_ == 0 || best_ == INVALID_LEVEL_PRICE || Better(price, best_))) {
+            // Either nothing lives in the window or the touch has moved past it
+            Rebase(price);
+        }
+        PriceLevel *level = nullptr;
+        if (InWindow(price)) {
+            level = &levels_[price - base_];
+            if (level->count_ == 0) {
+                MarkLevel(price - base_, true);
+            }
+        } else {
+            level = &overflow_[price];
+        }
+        Append(*level, handle);
+        if (best_ == INVALID_LEVEL_PRICE || Better(price, best_)) {
+            best_ = price;
+        }
+        return handle;
+    }
+
+    template <typename Tracker>
+    auto PriceLadder<Tracker>::Erase(OrderHandle handle) -> void {
+        Price price = entries_[handle].price_.GetPrice();
+        --size_;
+        if (price == MARKET_ORDER_PRICE) {
+            Unlink(market_, handle);
+            Release(handle);
+            return;
+        }
+        if (InWindow(price)) {
+            PriceLevel &level = levels_[price - base_];
+            Unlink(level, handle);
+            if (level.count_ == 0) {
+                MarkLevel(price - base_, false);
+            }
+        } else {
+            auto level = overflow_.find(price);
+            Unlink(level->second, handle);
+            if (level->second.count_ == 0) {
+                overflow_.erase(level);
+            }
+        }
+        Release(handle);
+        if (price == best_ && FindLevel(price) == nullptr) {
+            Price next = INVALID_LEVEL_PRICE;
+            best_      = WorseLevel(price, next) ? next : INVALID_LEVEL_PRICE;
+        }
+    }
+
+    template <typename Tracker>
+    auto PriceLadder<Tracker>::AdjustLevel(OrderHandle handle, int64_t delta) -> void {
+        Price       price = entries_[handle].price_.GetPrice();
+        PriceLevel *level = price == MARKET_ORDER_PRICE ? &market_ : FindLevel(price);
+        level->quantity_ += delta;
+    }
+
+    template <typename Tracker>
+    auto PriceLadder<Tracker>::Clear() -> void {
+        entries_.clear();
+        free_   = INVALID_ORDER_HANDLE;
+        market_ = PriceLevel{};
+        if (window_levels_ != 0) {
+            std::fill(levels_.begin(), levels_.end(), PriceLevel{});
+            std::fill(occupied_.begin(), occupied_.end(), 0);
+            window_levels_ = 0;
+        }
+        overflow_.clear();
+        best_ = INVALID_LEVEL_PRICE;
+        size_ = 0;
+    }
+
+    template <typename Tracker>
+    auto PriceLadder<Tracker>::At(OrderHandle handle) -> Entry & {
+        return entries_[handle];
+    }
+
+    template <typename Tracker>
+    auto PriceLadder<Tracker>::At(OrderHandle handle) const -> const Entry & {
+        return entries_[handle];
+    }
+
+    template <typename Tracker>
+    auto PriceLadder<Tracker>::Front() const -> OrderHandle {
+        if (market_.count_ != 0) {
+            return market_.head_;
+        }
+        return LevelFront(best_);
+    }
+
+    template <typename Tracker>
+    auto PriceLadder<Tracker>::Back() const -> OrderHandle {
+        Price worst = INVALID_LEVEL_PRICE;
+        if (WorstLevel(worst)) {
+            return FindLevel(worst)->tail_;
+        }
+        return market_.tail_;
+    }
+
+    template <typename Tracker>
+    auto PriceLadder<Tracker>::Next(OrderHandle handle) const -> OrderHandle {
+        const Entry &entry = entries_[handle];
+        if (entry.next_ != INVALID_ORDER_HANDLE) {
+            return entry.next_;
+        }
+        Price price = entry.price_.GetPrice();
+        if (price == MARKET_ORDER_PRICE) {
+            return LevelFront(best_);
+        }
+        Price next = INVALID_LEVEL_PRICE;
+        if (WorseLevel(price, next)) {
+            return LevelFront(next);
+        }
+        return INVALID_ORDER_HANDLE;
+    }
+
+    template <typename Tracker>
+    auto PriceLadder<Tracker>::Prev(OrderHandle handle) const -> OrderHandle {
+        const Entry &entry = entries_[handle];
+        if (entry.prev_ != INVALID_ORDER_HANDLE) {
+            return entry.prev_;
+        }
+        Price price = entry.price_.GetPrice();
+        if (price == MARKET_ORDER_PRICE) {
+            return INVALID_ORDER_HANDLE;
+        }
+        Price prev = INVALID_LEVEL_PRICE;
+        if (BetterLevel(price, prev)) {
+            return FindLevel(prev)->tail_;
+        }
+        return market_.tail_;
+    }
+
+    template <typename Tracker>
+    auto PriceLadder<Tracker>::LevelFront(Price price) const -> OrderHandle {
+        const PriceLevel *level = price == MARKET_ORDER_PRICE ? &market_ : FindLevel(price);
+        return level ? level->head_ : INVALID_ORDER_HANDLE;
+    }
+
+    template <typename Tracker>
+    auto PriceLadder<Tracker>::BestPrice() const -> Price {
+        return best_;
+    }
+
+    template <typename Tracker>
+    auto PriceLadder<Tracker>::Level(Price price) const -> const PriceLevel * {
+        if (price == MARKET_ORDER_PRICE) {
+            return market_.count_ ? &market_ : nullptr;
+        }
+        return FindLevel(price);
+    }
+
+    template <typename Tracker>
+    auto PriceLadder<Tracker>::NextLevel(Price price, Price &result) const -> bool {
+        return WorseLevel(price, result);
+    }
+
+    template <typename Tracker>
+    auto PriceLadder<Tracker>::size() const -> std::size_t {
+        return size_;
+    }
+
+    template <typename Tracker>
+    auto PriceLadder<Tracker>::empty() const -> bool {
+        return size_ == 0;
+    }
+
+    template <typename Tracker>
+    auto PriceLadder<Tracker>::begin() -> iterator {
+        return iterator(this, Front());
+    }
+
+    template <typename Tracker>
+    auto PriceLadder<Tracker>::end() -> iterator {
+        return iterator(this, INVALID_ORDER_HANDLE);
+    }
+
+    template <typename Tracker>
+    auto PriceLadder<Tracker>::begin() const -> const_iterator {
+        return const_iterator(this, Front());
+    }
+
+    template <typename Tracker>
+    auto PriceLadder<Tracker>::end() const -> const_iterator {
+        return const_iterator(this, INVALID_ORDER_HANDLE);
+    }
+
+    template <typename Tracker>
+    auto PriceLadder<Tracker>::rbegin() -> reverse_iterator {
+        return reverse_iterator(end());
+    }
+
+    template <typename Tracker>
+    auto PriceLadder<Tracker>::rend() -> reverse_iterator {
+        return reverse_iterator(begin());
+    }
+
+    template <typename Tracker>
+    auto PriceLadder<Tracker>::rbegin() const -> const_reverse_iterator {
+        return const_reverse_iterator(end());
+    }
+
+    template <typename Tracker>
+    auto PriceLadder<Tracker>::rend() const -> const_reverse_iterator {
+        return const_reverse_iterator(begin());
+    }
+
+    template <typename Tracker>
+    auto PriceLadder<Tracker>::Better(Price lhs, Price rhs) const -> bool {
+        return buy_side_ ? lhs > rhs : lhs < rhs;
+    }
+
+    template <typename Tracker>
+    auto PriceLadder<Tracker>::InWindow(Price price) const -> bool {
+        return price >= base_ && price - base_ < levels_.size();
+    }
+
+    template <typename Tracker>
+    auto PriceLadder<Tracker>::FindLevel(Price price) -> PriceLevel * {
+        return const_cast<PriceLevel *>(static_cast<const PriceLadder *>(this)->FindLevel(price));
+    }
+
+    template <typename Tracker>
+    auto PriceLadder<Tracker>::FindLevel(Price price) const -> const PriceLevel * {
+        if (price == INVALID_LEVEL_PRICE) {
+            return nullptr;
+        }
+        if (InWindow(price)) {
+            const PriceLevel &level = levels_[price - base_];
+            return level.count_ ? &level : nullptr;
+        }
+        auto level = overflow_.find(price);
+        return level != overflow_.end() ? &level->second : nullptr;
+    }
+
+    template <typename Tracker>
+    auto PriceLadder<Tracker>::WorseLevel(Price price, Price &result) const -> bool {
+        // Nearest occupied level strictly behind price, looked up in both the window and the overflow
+        bool  found     = false;
+        Price candidate = INVALID_LEVEL_PRICE;
+        if (buy_side_) {
+            if (price > base_) {
+                std::size_t from  = (std::min)(price - base_ - 1, levels_.size() - 1);
+                std::size_t index = ScanDown(from);
+                if (index != levels_.size()) {
+                    candidate = base_ + index;
+                    found     = true;
+                }
+            }
+            auto level = overflow_.lower_bound(price);
+            if (level != overflow_.begin() && (!found || std::prev(level)->first > candidate)) {
+                candidate = std::prev(level)->first;
+                found     = true;
+            }
+        } else {
+            if (price + 1 < base_ + levels_.size()) {
+                std::size_t from  = price < base_ ? 0 : price - base_ + 1;
+                std::size_t index = ScanUp(from);
+                if (index != levels_.size()) {
+                    candidate = base_ + index;
+                    found     = true;
+                }
+            }
+            auto level = overflow_.upper_bound(price);
+            if (level != overflow_.end() && (!found || level->first < candidate)) {
+                candidate = level->first;
+                found     = true;
+            }
+        }
+        if (found) {
+            result = candidate;
+        }
+        return found;
+    }
+
+    template <typename Tracker>
+    auto PriceLadder<Tracker>::BetterLevel(Price price, Price &result) const -> bool {
+        bool  found     = false;
+        Price candidate = INVALID_LEVEL_PRICE;
+        if (buy_side_) {
+            if (price + 1 < base_ + levels_.size()) {
+                std::size_t from  = price < base_ ? 0 : price - base_ + 1;
+                std::size_t index = ScanUp(from);
+                if (index != levels_.size()) {
+                    candidate = base_ + index;
+                    found     = true;
+                }
+            }
+            auto level = overflow_.upper_bound(price);
+            if (level != overflow_.end() && (!found || level->first < candidate)) {
+                candidate = level->first;
+                found     = true;
+            }
+        } else {
+            if (price > base_) {
+                std::size_t from  = (std::min)(price - base_ - 1, levels_.size() - 1);
+                std::size_t index = ScanDown(from);
+                if (index != levels_.size()) {
+                    candidate = base_ + index;
+                    found     = true;
+                }
+            }
+            auto level = overflow_.lower_bound(price);
+            if (level != overflow_.begin() && (!found || std::prev(level)->first > candidate)) {
+                candidate = std::prev(level)->first;
+                found     = true;
+            }
+        }
+        if (found) {
+            result = candidate;
+        }
+        return found;
+    }
+
+    template <typename Tracker>
+    auto PriceLadder<Tracker>::WorstLevel(Price &result) const -> bool {
+        if (best_ == INVALID_LEVEL_PRICE) {
+            return false;
+        }
+        // Walk past the far edge of the ladder and come back one level
+        return BetterLevel(buy_side_ ? MARKET_ORDER_PRICE : UINT64_MAX, result);
+    }
+
+    template <typename Tracker>
+    auto PriceLadder<Tracker>::ScanDown(std::size_t from) const -> std::size_t {
+        std::size_t word = from / 64;
+        uint64_t    bits = occupied_[word] & (~uint64_t{0} >> (63 - from % 64));
+        while (true) {
+            if (bits) {
+                return word * 64 + 63 - std::countl_zero(bits);
+            }
+            if (word == 0) {
+                return levels_.size();
+            }
+            bits = occupied_[--word];
+        }
+    }
+
+    template <typename Tracker>
+    auto PriceLadder<Tracker>::ScanUp(std::size_t from) const -> std::size_t {
+        std::size_t word = from / 64;
+        uint64_t    bits = occupied_[word] & (~uint64_t{0} << (from % 64));
+        while (true) {
+            if (bits) {
+                return word * 64 + std::countr_zero(bits);
+            }
+            if (++word == occupied_.size()) {
+                return levels_.size();
+            }
+            bits = occupied_[word];
+        }
+    }
+
+    template <typename Tracker>
+    auto PriceLadder<Tracker>::Rebase(Price price) -> void {
+        std::size_t half     = levels_.size() / 2;
+        Price       new_base = price > half ? price - half : 0;
+
+        for (std::size_t index = 0; window_levels_ != 0 && index < levels_.size(); ++index) {
+            if (levels_[index].count_) {
+                overflow_.emplace(base_ + index, levels_[index]);
+                levels_[index] = PriceLevel{};
+                MarkLevel(index, false);
+            }
+        }
+
+        base_     = new_base;
+        auto from = overflow_.lower_bound(base_);
+        auto to   = overflow_.lower_bound(base_ + levels_.size());
+        for (auto level = from; level != to; ++level) {
+            levels_[level->first - base_] = level->second;
+            MarkLevel(level->first - base_, true);
+        }
+        overflow_.erase(from, to);
+    }
+
+    template <typename Tracker>
+    auto PriceLadder<Tracker>::MarkLevel(std::size_t index, bool occupied) -> void {
+        if (occupied) {
+            occupied_[index / 64] |= uint64_t{1} << (index % 64);
+            ++window_levels_;
+        } else {
+            occupied_[index / 64] &= ~(uint64_t{1} << (index % 64));
+            --window_levels_;
+        }
+    }
+
+    template <typename Tracker>
+    auto PriceLadder<Tracker>::Allocate(const Tracker &tracker, Price price) -> OrderHandle {
+        OrderHandle handle = free_;
+        if (handle != INVALID_ORDER_HANDLE) {
+            Entry &entry   = entries_[handle];
+            free_          = entry.next_;
+            entry.price_   = ComparablePrice(buy_side_, price);
+            entry.tracker_ = tracker;
+            entry.next_    = INVALID_ORDER_HANDLE;
+        } else {
+            handle = static_cast<OrderHandle>(entries_.size());
+            entries_.push_back(Entry{ComparablePrice(buy_side_, price), tracker});
+        }
+        return handle;
+    }
+
+    template <typename Tracker>
+    auto PriceLadder<Tracker>::Release(OrderHandle handle) -> void {
+        Entry &entry         = entries_[handle];
+        entry.tracker_.Ptr() = {};
+        entry.prev_          = INVALID_ORDER_HANDLE;
+        entry.next_          = free_;
+        free_                = handle;
+    }
+
+    template <typename Tracker>
+    auto PriceLadder<Tracker>::Append(PriceLevel &level, OrderHandle handle) -> void {
+        Entry &entry = entries_[handle];
+        entry.prev_  = level.tail_;
+        entry.next_  = INVALID_ORDER_HANDLE;
+        if (level.tail_ != INVALID_ORDER_HANDLE) {
+            entries_[level.tail_].next_ = handle;
+        } else {
+            level.head_ = handle;
+        }
+        level.tail_ = handle;
+        ++level.count_;
+        level.quantity_ += entry.tracker_.OpenQty();
+    }
+
+    template <typename Tracker>
+    auto PriceLadder<Tracker>::Unlink(PriceLevel &level, OrderHandle handle) -> void {
+        Entry &entry = entries_[handle];
+        if (entry.prev_ != INVALID_ORDER_HANDLE) {
+            entries_[entry.prev_].next_ = entry.next_;
+        } else {
+            level.head_ = entry.next_;
+        }
+        if (entry.next_ != INVALID_ORDER_HANDLE) {
+            entries_[entry.next_].prev_ = entry.prev_;
+        } else {
+            level.tail_ = entry.prev_;
+        }
+        --level.count_;
+        level.quantity_ -= entry.tracker_.OpenQty();
+    }
+}    // namespace lhft::book
@@ -0,0 +1,114 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "command.hpp"
+#include "market.hpp"
+#include "spsc_ring.hpp"
+#include "thread_util.hpp"
+#include "trade_tape.hpp"
+
+namespace lhft::me {
+    // Outcome of one command (ORDER_TICK) or a trade it caused (TRADE_EVENT_TICK), the trades of a
+    // command right behind its own report. stream_header_.seq_no_ comes from a single outbound
+    // sequencer, so the reports of all shards form one gap free sequence.
+    struct ShardReport {
+        book::StreamHeader stream_header_{};
+        std::size_t        shard_{0};
+        Command            command_{};
+        bool               result_{};
+        book::TradeData    trade_{};    // TRADE_EVENT_TICK only
+    };
+
+    // Symbols are partitioned across worker threads, each one owning a BasicMarket with its books,
+    // its orders and its order index. Commands are pushed onto the owning worker's SpscRing and return
+    // at once, so routing them is left to a single gateway thread; results come back as ShardReport
+    // through Poll. Orders are created on the worker, so the storage policy is never shared between
+    // threads. Fill ids are counted per book, symbol and fill id together identify a trade.
+    template <typename OrderStorage>
+    class BasicShardedMarket {
+    public:
+        using OrderId  = book::OrderId;
+        using Symbol   = book::Symbol;
+        using Market   = BasicMarket<OrderStorage>;
+        using Reports  = std::vector<ShardReport>;
+        using Commands = std::vector<Command>;
+
+        // cores[i] is the cpu shard i is pinned to, shards without an entry are left unpinned
+        explicit BasicShardedMarket(std::size_t shards, std::vector<int> cores = {});
+
+        BasicShardedMarket(const BasicShardedMarket &) = delete;
+
+        auto operator=(const BasicShardedMarket &) -> BasicShardedMarket & = delete;
+
+        ~BasicShardedMarket();
+
+        [[nodiscard]] auto Shards() const -> std::size_t;
+
+        [[nodiscard]] auto ShardOf(Symbol symbol) const -> std::size_t;
+
+        auto AddBook(Symbol symbol) -> void;
+
+        auto RemoveBook(Symbol symbol) -> void;
+
+        auto OrderSubmit(OrderId order_id, bool buy_side, Symbol symbol, book::Quantity quantity, book::Price price,
+                         book::Owner owner = book::ANY_OWNER) -> void;
+
+        // The symbol routes the cancel, order ids are only indexed inside their shard
+        auto OrderCancel(Symbol symbol, OrderId order_id) -> void;
+
+        // Cancels the orders of the book of symbol that pass filter, see BasicMarket::OrderMassCancel
+        auto OrderMassCancel(Symbol symbol, const book::MassCancelFilter &filter = book::MassCancelFilter()) -> void;
+
+        // Blocks until every command queued so far has been processed and reported
+        auto Wait() -> void;
+
+        // Moves the reports published so far into reports, in sequence order
+        auto Poll(Reports &reports) -> std::size_t;
+
+    private:
+        // tape_ collects the trades of the shard's books between commands, declared first so that it
+        // outlives the market writing to it. A worker whose ring stays empty for SHARD_SPIN_LIMIT polls
+        // parks on ready_, parked_ tells Route to wake it.
+        struct Shard {
+            book::TradeTape          tape_{};
+            Market                   market_{};
+            SpscRing<Command>        ring_{book::COMMAND_RING_CAPACITY};
+            std::size_t              queued_{0};    // only touched by the routing thread
+            std::atomic<std::size_t> done_{0};
+            std::atomic<bool>        parked_{false};
+            std::atomic<bool>        running_{true};
+            std::mutex               mutex_{};
+            std::condition_variable  ready_{};
+            std::thread              worker_{};
+        };
+
+        auto Route(const Command &command) -> void;
+
+        auto Run(std::size_t index, Shard &shard) -> void;
+
+        // Blocks the worker until a command arrives or the market shuts down
+        auto Park(Shard &shard) -> void;
+
+        auto Publish(Reports &batch) -> void;
+
+        std::vector<std::unique_ptr<Shard>> shards_{};
+        std::mutex                          reports_mutex_{};
+        Reports                             reports_{};
+        std::size_t                         seq_no_{0};
+    };
+
+    using ShardedMarket       = BasicShardedMarket<SharedOrders>;
+    using PooledShardedMarket = BasicShardedMarket<PooledOrders>;
+
+    extern template class BasicShardedMarket<SharedOrders>;
+    extern template class BasicShardedMarket<PooledOrders>;
+}    // namespace lhft::me
+
+#include "sharded_market.inl"
@@ -0,0 +1,164 @@
+namespace lhft::me {
+    template <typename OrderStorage>
+    BasicShardedMarket<OrderStorage>::BasicShardedMarket(std::size_t shards, std::vector<int> cores) {
+        shards_.reserve(shards ? shards : 1);
+        for (std::size_t index = 0; index < (shards ? shards : 1); ++index) {
+            auto &shard = *shards_.emplace_back(std::make_unique<Shard>());
+            shard.market_.SetTradeTape(&shard.tape_);
+            shard.worker_ = std::thread([this, index, &shard] { Run(index, shard); });
+            if (index < cores.size() && cores[index] >= 0 && !PinThread(shard.worker_, cores[index])) {
+                LOG_ERROR("Can't pin shard {} to core {}", index, cores[index]);
+            }
+        }
+    }
+
+    template <typename OrderStorage>
+    BasicShardedMarket<OrderStorage>::~BasicShardedMarket() {
+        for (auto &shard : shards_) {
+            shard->running_.store(false, std::memory_order_release);
+            std::lock_guard lock(shard->mutex_);
+            shard->ready_.notify_one();
+        }
+        for (auto &shard : shards_) {
+            shard->worker_.join();
+        }
+    }
+
+    template <typename OrderStorage>
+    auto BasicShardedMarket<OrderStorage>::Shards() const -> std::size_t {
+        return shards_.size();
+    }
+
+    template <typename OrderStorage>
+    auto BasicShardedMarket<OrderStorage>::ShardOf(Symbol symbol) const -> std::size_t {
+        return symbol % shards_.size();
+    }
+
+    template <typename OrderStorage>
+    auto BasicShardedMarket<OrderStorage>::AddBook(Symbol symbol) -> void {
+        Route(Command{CommandType::ADD_BOOK, 0, false, symbol, 0, 0});
+    }
+
+    template <typename OrderStorage>
+    auto BasicShardedMarket<OrderStorage>::RemoveBook(Symbol symbol) -> void {
+        Route(Command{CommandType::REMOVE_BOOK, 0, false, symbol, 0, 0});
+    }
+
+    template <typename OrderStorage>
+    auto BasicShardedMarket<OrderStorage>::OrderSubmit(OrderId order_id, bool buy_side, Symbol symbol,
+                                                       book::Quantity quantity, book::Price price,
+                                                       book::Owner owner) -> void {
+        Command command{CommandType::SUBMIT, order_id, buy_side, symbol, quantity, price};
+        command.owner_ = owner;
+        Route(command);
+    }
+
+    template <typename OrderStorage>
+    auto BasicShardedMarket<OrderStorage>::OrderCancel(Symbol symbol, OrderId order_id) -> void {
+        Route(Command{CommandType::CANCEL, order_id, false, symbol, 0, 0});
+    }
+
+    template <typename OrderStorage>
+    auto BasicShardedMarket<OrderStorage>::OrderMassCancel(Symbol symbol, const book::MassCancelFilter &filter)
+            -> void {
+        Command command{CommandType::MASS_CANCEL, 0, false, symbol, 0, 0};
+        command.owner_       = filter.owner_;
+        command.cancel_bids_ = filter.bids_;
+        command.cancel_asks_ = filter.asks_;
+        Route(command);
+    }
+
+    template <typename OrderStorage>
+    auto BasicShardedMarket<OrderStorage>::Wait() -> void {
+        for (auto &shard : shards_) {
+            while (shard->done_.load(std::memory_order_acquire) != shard->queued_) {
+                std::this_thread::yield();
+            }
+        }
+    }
+
+    template <typename OrderStorage>
+    auto BasicShardedMarket<OrderStorage>::Poll(Reports &reports) -> std::size_t {
+        std::lock_guard lock(reports_mutex_);
+        std::size_t     count = reports_.size();
+        reports.insert(reports.end(), reports_.begin(), reports_.end());
+        reports_.clear();
+        return count;
+    }
+
+    template <typename OrderStorage>
+    auto BasicShardedMarket<OrderStorage>::Route(const Command &command) -> void {
+        auto &shard = *shards_[ShardOf(command.symbol_)];
+        while (!shard.ring_.TryPush(command)) {
+            CpuRelax();
+        }
+        ++shard.queued_;
+        // Pairs with the fence in Park: either the worker sees the command or Route sees it parked
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (shard.parked_.load(std::memory_order_relaxed)) {
+            std::lock_guard lock(shard.mutex_);
+            shard.ready_.notify_one();
+        }
+    }
+
+    template <typename OrderStorage>
+    auto BasicShardedMarket<OrderStorage>::Run(std::size_t index, Shard &shard) -> void {
+        Commands        working(book::COMMAND_BATCH_SIZE);
+        Reports         batch;
+        book::TradeData trades[64];
+        std::size_t     idle = 0;
+        for (;;) {
+            std::size_t count = shard.ring_.PopBatch(working.data(), working.size());
+            if (count == 0) {
+                if (!shard.running_.load(std::memory_order_acquire) && shard.ring_.Empty()) {
+                    return;
+                }
+                if (++idle < book::SHARD_SPIN_LIMIT) {
+                    CpuRelax();
+                } else {
+                    Park(shard);
+                    idle = 0;
+                }
+                continue;
+            }
+            idle = 0;
+
+            shard.market_.BeginBatch();
+            for (std::size_t next = 0; next < count; ++next) {
+                const auto &command = working[next];
+                batch.push_back(ShardReport{{{}, book::ORDER_TICK}, index, command, shard.market_.Apply(command)});
+                for (std::size_t read; (read = shard.tape_.Read(0, trades, std::size(trades))) != 0;) {
+                    for (std::size_t trade = 0; trade < read; ++trade) {
+                        batch.push_back(ShardReport{{{}, book::TRADE_EVENT_TICK}, index, command, true, trades[trade]});
+                    }
+                }
+            }
+            shard.market_.EndBatch();
+            Publish(batch);
+            shard.done_.fetch_add(count, std::memory_order_release);
+        }
+    }
+
+    template <typename OrderStorage>
+    auto BasicShardedMarket<OrderStorage>::Park(Shard &shard) -> void {
+        shard.parked_.store(true, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        {
+            std::unique_lock lock(shard.mutex_);
+            shard.ready_.wait(lock, [&shard] {
+                return !shard.ring_.Empty() || !shard.running_.load(std::memory_order_acquire);
+            });
+        }
+        shard.parked_.store(false, std::memory_order_relaxed);
+    }
+
+    template <typename OrderStorage>
+    auto BasicShardedMarket<OrderStorage>::Publish(Reports &batch) -> void {
+        std::lock_guard lock(reports_mutex_);
+        for (auto &report : batch) {
+            report.stream_header_.seq_no_ = ++seq_no_;
+            reports_.push_back(report);
+        }
+        batch.clear();
+    }
+}    // namespace lhft::me
@@ -0,0 +1,100 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#include "order.hpp"
+#include "types.hpp"
+
+namespace lhft::book {
+    struct SnapshotHeader {
+        char     magic_[8]{};
+        uint32_t version_{0};
+        uint32_t books_{0};
+        uint64_t orders_{0};
+        uint64_t journal_seq_no_{0};    // last journal record contained in the snapshot
+    };
+
+    struct BookSnapshot {
+        Symbol   symbol_{0};
+        Price    market_price_{0};
+        FillId   fill_id_{0};
+        uint64_t bids_{0};
+        uint64_t asks_{0};
+        uint64_t stops_{0};
+        bool     auction_{};    // the book was in its call phase
+        uint8_t  reserved_[7]{};
+    };
+
+    // One resting order, bids and asks are each stored in price-time order and waiting stops in
+    // the order they would trigger
+    struct RestingOrder {
+        OrderId     id_{0};
+        Quantity    quantity_{0};
+        Price       price_{0};
+        Quantity    quantity_on_market_{0};
+        Quantity    quantity_filled_{0};
+        Cost        fill_cost_{0};
+        Price       stop_price_{0};
+        Owner       owner_{ANY_OWNER};
+        bool        buy_side_{};
+        bool        post_only_{};
+        TimeInForce time_in_force_{TimeInForce::GTC};
+        uint8_t     reserved_[1]{};
+    };
+
+    // Snapshot files are built in memory and written with a single write. Records spell out their
+    // padding as reserved_ bytes, so a value-initialized record has no indeterminate bytes
+    class SnapshotWriter {
+    public:
+        template <typename T>
+        auto Write(const T &value) -> void;
+
+        auto Save(const std::string &file_name) const -> bool;
+
+    private:
+        std::vector<std::byte> buffer_{};
+    };
+
+    // Loads a whole snapshot file and hands out its records in order
+    class SnapshotReader {
+    public:
+        auto Load(const std::string &file_name) -> bool;
+
+        template <typename T>
+        [[nodiscard]] auto Read(T &value) -> bool;
+
+        [[nodiscard]] auto AtEnd() const -> bool;
+        [[nodiscard]] auto Remaining() const -> std::size_t;
+
+    private:
+        std::vector<std::byte> buffer_{};
+        std::size_t            position_{0};
+    };
+
+    auto MakeSnapshotHeader(uint32_t books, uint64_t orders, uint64_t journal_seq_no) -> SnapshotHeader;
+
+    [[nodiscard]] auto ValidSnapshotHeader(const SnapshotHeader &header) -> bool;
+
+    template <typename T>
+    auto SnapshotWriter::Write(const T &value) -> void {
+        static_assert(std::is_trivially_copyable_v<T> && std::has_unique_object_representations_v<T>);
+        const auto *bytes = reinterpret_cast<const std::byte *>(&value);
+        buffer_.insert(buffer_.end(), bytes, bytes + sizeof(T));
+    }
+
+    template <typename T>
+    auto SnapshotReader::Read(T &value) -> bool {
+        static_assert(std::is_trivially_copyable_v<T>);
+        if (buffer_.size() - position_ < sizeof(T)) {
+            return false;
+        }
+        std::memcpy(&value, buffer_.data() + position_, sizeof(T));
+        position_ += sizeof(T);
+        return true;
+    }
+}    // namespace lhft::book
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <type_traits>
+#include <vector>
+
+namespace lhft::me {
+    // Bounded single producer/single consumer ring of trivially copyable records. The producer and
+    // consumer indices live on separate cache lines and each side keeps a cached copy of the other
+    // one, so the shared lines are only touched when the ring looks full or empty.
+    template <typename T>
+    class SpscRing {
+        static_assert(std::is_trivially_copyable_v<T>, "ring records must be trivially copyable");
+
+    public:
+        // capacity is rounded up to a power of two
+        explicit SpscRing(std::size_t capacity);
+
+        SpscRing(const SpscRing &) = delete;
+
+        auto operator=(const SpscRing &) -> SpscRing & = delete;
+
+        [[nodiscard]] auto TryPush(const T &value) -> bool;
+
+        [[nodiscard]] auto TryPop(T &value) -> bool;
+
+        // Pops up to max records into out with a single release of the consumed slots
+        auto PopBatch(T *out, std::size_t max) -> std::size_t;
+
+        [[nodiscard]] auto Size() const -> std::size_t;
+
+        [[nodiscard]] auto Empty() const -> bool;
+
+        [[nodiscard]] auto Capacity() const -> std::size_t;
+
+    private:
+        static constexpr std::size_t CACHE_LINE = 64;
+
+        std::vector<T> slots_;
+        std::size_t    mask_;
+
+        alignas(CACHE_LINE) std::atomic<std::size_t> head_{0};
+        std::size_t cached_tail_{0};
+
+        alignas(CACHE_LINE) std::atomic<std::size_t> tail_{0};
+        std::size_t cached_head_{0};
+    };
+}    // namespace lhft::me
+
+#include "spsc_ring.inl"
@@ -0,0 +1,60 @@
+#include <algorithm>
+#include <bit>
+
+namespace lhft::me {
+    template <typename T>
+    SpscRing<T>::SpscRing(std::size_t capacity)
+        : slots_(std::bit_ceil(capacity ? capacity : 1)), mask_(slots_.size() - 1) {
+    }
+
+    template <typename T>
+    auto SpscRing<T>::TryPush(const T &value) -> bool {
+        std::size_t head = head_.load(std::memory_order_relaxed);
+        if (head - cached_tail_ == slots_.size()) {
+            cached_tail_ = tail_.load(std::memory_order_acquire);
+            if (head - cached_tail_ == slots_.size()) {
+                return false;
+            }
+        }
+        slots_[head & mask_] = value;
+        head_.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    template <typename T>
+    auto SpscRing<T>::TryPop(T &value) -> bool {
+        return PopBatch(&value, 1) == 1;
+    }
+
+    template <typename T>
+    auto SpscRing<T>::PopBatch(T *out, std::size_t max) -> std::size_t {
+        std::size_t tail = tail_.load(std::memory_order_relaxed);
+        if (cached_head_ == tail) {
+            cached_head_ = head_.load(std::memory_order_acquire);
+            if (cached_head_ == tail) {
+                return 0;
+            }
+        }
+        std::size_t count = std::min(max, cached_head_ - tail);
+        for (std::size_t index = 0; index < count; ++index) {
+            out[index] = slots_[(tail + index) & mask_];
+        }
+        tail_.store(tail + count, std::memory_order_release);
+        return count;
+    }
+
+    template <typename T>
+    auto SpscRing<T>::Size() const -> std::size_t {
+        return head_.load(std::memory_order_acquire) - tail_.load(std::memory_order_acquire);
+    }
+
+    template <typename T>
+    auto SpscRing<T>::Empty() const -> bool {
+        return Size() == 0;
+    }
+
+    template <typename T>
+    auto SpscRing<T>::Capacity() const -> std::size_t {
+        return slots_.size();
+    }
+}    // namespace lhft::me
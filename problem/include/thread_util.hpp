@@ -0,0 +1,17 @@
+#pragma once
+
+#include <thread>
+
+namespace lhft::me {
+    // Pins thread to cpu core, negative cores and unsupported platforms leave it unpinned
+    auto PinThread(std::thread &thread, int core) -> bool;
+
+    // Spin loop hint for busy polling threads
+    inline auto CpuRelax() -> void {
+#if defined(__x86_64__) || defined(__i386__)
+        __builtin_ia32_pause();
+#elif defined(__aarch64__)
+        asm volatile("yield");
+#endif
+    }
+}    // namespace lhft::me
@@ -0,0 +1,114 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "order.hpp"
+#include "types.hpp"
+
+namespace lhft::book {
+    // Preallocated ring of TradeData written by the matching thread and read by a fixed set of
+    // readers, each with its own cursor, so every reader sees every trade. Append never blocks and
+    // never allocates: when the slowest reader is a full ring behind, the trade is dropped and
+    // counted. Sequence numbers are stamped before that check, so readers see the gap.
+    class TradeTape {
+    public:
+        explicit TradeTape(std::size_t capacity = TRADE_TAPE_CAPACITY, std::size_t readers = 1);
+
+        TradeTape(const TradeTape &) = delete;
+
+        auto operator=(const TradeTape &) -> TradeTape & = delete;
+
+        auto Append(const TradeData &trade) -> bool;
+
+        // Copies up to max unread trades of reader into out
+        auto Read(std::size_t reader, TradeData *out, std::size_t max) -> std::size_t;
+
+        [[nodiscard]] auto SeqNo() const -> std::size_t;
+
+        [[nodiscard]] auto Dropped() const -> std::size_t;
+
+        [[nodiscard]] auto Capacity() const -> std::size_t;
+
+        [[nodiscard]] auto Readers() const -> std::size_t;
+
+    private:
+        struct alignas(64) Cursor {
+            std::atomic<std::size_t> position_{0};
+        };
+
+        auto SlowestReader() const -> std::size_t;
+
+        std::vector<TradeData>    slots_;
+        std::size_t               mask_;
+        std::unique_ptr<Cursor[]> cursors_;
+        std::size_t               readers_;
+
+        alignas(64) std::atomic<std::size_t> head_{0};
+        std::size_t              cached_slowest_{0};
+        std::size_t              seq_no_{0};
+        std::atomic<std::size_t> dropped_{0};
+    };
+
+    // Drains one reader of a tape to a file of raw TradeData records on a background thread, which
+    // sleeps briefly whenever the tape has nothing new
+    class TradeFileWriter {
+    public:
+        TradeFileWriter(TradeTape &tape, std::size_t reader);
+
+        TradeFileWriter(const TradeFileWriter &) = delete;
+
+        auto operator=(const TradeFileWriter &) -> TradeFileWriter & = delete;
+
+        ~TradeFileWriter();
+
+        auto Start(const std::string &file_name) -> bool;
+
+        // Writes the trades still unread, then closes the file
+        auto Stop() -> void;
+
+        [[nodiscard]] auto Written() const -> std::size_t;
+
+    private:
+        auto Run() -> void;
+
+        auto Drain() -> std::size_t;
+
+        TradeTape &              tape_;
+        std::size_t              reader_;
+        std::vector<TradeData>   buffer_;
+        std::FILE *              file_{nullptr};
+        std::atomic<bool>        running_{false};
+        std::atomic<std::size_t> written_{0};
+        std::thread              worker_{};
+    };
+
+    // Hands the trades of one reader of a tape to handler, one call per trade, on whatever thread
+    // polls it, typically the market data publisher's
+    template <typename Handler>
+    class TradePublisher {
+    public:
+        TradePublisher(TradeTape &tape, std::size_t reader, Handler handler = Handler());
+
+        // Publishes up to one batch of unread trades, returns how many
+        auto Poll() -> std::size_t;
+
+        auto GetHandler() -> Handler &;
+
+    private:
+        static constexpr std::size_t BATCH = 64;
+
+        TradeTape & tape_;
+        std::size_t reader_;
+        Handler     handler_;
+        TradeData   batch_[BATCH]{};
+    };
+}    // namespace lhft::book
+
+#include "trade_tape.inl"
@@ -0,0 +1,20 @@
+namespace lhft::book {
+    template <typename Handler>
+    TradePublisher<Handler>::TradePublisher(TradeTape &tape, std::size_t reader, Handler handler)
+        : tape_(tape), reader_(reader), handler_(std::move(handler)) {
+    }
+
+    template <typename Handler>
+    auto TradePublisher<Handler>::Poll() -> std::size_t {
+        std::size_t count = tape_.Read(reader_, batch_, BATCH);
+        for (std::size_t index = 0; index < count; ++index) {
+            handler_(batch_[index]);
+        }
+        return count;
+    }
+
+    template <typename Handler>
+    auto TradePublisher<Handler>::GetHandler() -> Handler & {
+        return handler_;
+    }
+}    // namespace lhft::book
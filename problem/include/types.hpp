@@ -10,6 +10,9 @@ namespace lhft::book {
     using ChangeId = std::size_t;
     using OrderId  = std::size_t;
     using Symbol   = std::size_t;
+    using Owner    = uint32_t;    // session or account that entered an order
+
+    using OrderHandle = uint32_t;
 
     namespace {
         const Price   MARKET_ORDER_PRICE(0);
@@ -18,7 +21,35 @@ namespace lhft::book {
         const Price   INVALID_LEVEL_PRICE(0);
         const Price   MARKET_ORDER_BID_SORT_PRICE(UINT32_MAX);
         const Price   MARKET_ORDER_ASK_SORT_PRICE(0);
+
+        const OrderHandle INVALID_ORDER_HANDLE(UINT32_MAX);
+
+        const Owner ANY_OWNER(0);
     }    // namespace
 
     static const int32_t BOOK_DEPTH = 10;
+
+    static const std::size_t ORDER_HISTORY_DEPTH = 8;
+
+    static const std::size_t LADDER_TICKS = 1024;
+
+    static const std::size_t STOP_LADDER_TICKS = 64;
+
+    static const std::size_t ORDER_POOL_CAPACITY = 1 << 16;
+
+    static const std::size_t ORDER_INDEX_CAPACITY = 1 << 12;
+
+    static const std::size_t COMMAND_RING_CAPACITY = 1 << 16;
+
+    static const std::size_t COMMAND_BATCH_SIZE = 64;
+
+    static const std::size_t SHARD_SPIN_LIMIT = 1 << 12;    // empty polls before a shard worker parks
+
+    static const std::size_t TRADE_TAPE_CAPACITY = 1 << 14;
+
+    static const std::size_t JOURNAL_CAPACITY = 1 << 16;
+
+    static const std::size_t JOURNAL_COMMIT_BATCH = 256;
+
+    static const Symbol DEFAULT_SYMBOL = 1;
 }    // namespace lhft::book
\ No newline at end of file
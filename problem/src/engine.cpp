@@ -0,0 +1,6 @@
+#include <engine.hpp>
+
+namespace lhft::me {
+    template class BasicEngine<SharedOrders>;
+    template class BasicEngine<PooledOrders>;
+}    // namespace lhft::me
@@ -0,0 +1,259 @@
+#include <journal.hpp>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+
+#include "logger.hpp"
+
+namespace lhft::me {
+    namespace {
+        constexpr char     JOURNAL_MAGIC[8] = {'L', 'H', 'F', 'T', 'J', 'R', 'N', 'L'};
+        constexpr uint32_t JOURNAL_VERSION  = 1;
+
+        auto FileLength(std::size_t capacity) -> std::size_t {
+            return sizeof(JournalHeader) + capacity * sizeof(JournalRecord);
+        }
+
+        auto Now() -> uint64_t {
+            return std::chrono::duration_cast<std::chrono::nanoseconds>(
+                           std::chrono::system_clock::now().time_since_epoch())
+                    .count();
+        }
+    }    // namespace
+
+    auto ValidRecords(const JournalRecord *records, std::size_t committed) -> std::size_t {
+        std::size_t size = 0;
+        while (size < committed && records[size].seq_no_ == size + 1) {
+            ++size;
+        }
+        return size;
+    }
+
+    CommandJournal::CommandJournal(std::size_t commit_every) : commit_every_(commit_every ? commit_every : 1) {
+    }
+
+    CommandJournal::~CommandJournal() {
+        Close();
+    }
+
+    auto CommandJournal::Open(const std::string &file_name, std::size_t capacity) -> bool {
+        Close();
+        fd_ = ::open(file_name.c_str(), O_RDWR | O_CREAT, 0644);
+        if (fd_ < 0) {
+            LOG_ERROR("Can't open journal {}", file_name);
+            return false;
+        }
+        struct stat status {};
+        ::fstat(fd_, &status);
+        auto length = static_cast<std::size_t>(status.st_size);
+
+        if (length >= sizeof(JournalHeader)) {
+            JournalHeader header;
+            if (::pread(fd_, &header, sizeof(header), 0) != sizeof(header) ||
+                std::memcmp(header.magic_, JOURNAL_MAGIC, sizeof(JOURNAL_MAGIC)) != 0 ||
+                header.version_ != JOURNAL_VERSION || header.record_size_ != sizeof(JournalRecord)) {
+                LOG_ERROR("{} is not a journal", file_name);
+                Close();
+                return false;
+            }
+            // Records past the committed count were never made durable, or belong to an earlier run:
+            // cutting the file back to the committed records and growing it again zeroes them
+            std::size_t existing  = (length - sizeof(JournalHeader)) / sizeof(JournalRecord);
+            std::size_t committed = std::min<std::size_t>(header.committed_, existing);
+            if (::ftruncate(fd_, static_cast<off_t>(FileLength(committed))) != 0 ||
+                !Map(std::max(committed, capacity ? capacity : 1))) {
+                LOG_ERROR("Can't drop the uncommitted records of journal {}", file_name);
+                Close();
+                return false;
+            }
+            size_      = ValidRecords(Records(), committed);
+            committed_ = size_;
+            if (size_ != header.committed_) {
+                LOG_ERROR("Journal {} holds {} of its {} committed records", file_name, size_, header.committed_);
+                reinterpret_cast<JournalHeader *>(base_)->committed_ = size_;
+                ::msync(base_, sizeof(JournalHeader), MS_SYNC);
+            }
+            return true;
+        }
+
+        if (!Map(capacity ? capacity : 1)) {
+            Close();
+            return false;
+        }
+        auto *header = reinterpret_cast<JournalHeader *>(base_);
+        std::memcpy(header->magic_, JOURNAL_MAGIC, sizeof(JOURNAL_MAGIC));
+        header->version_     = JOURNAL_VERSION;
+        header->record_size_ = sizeof(JournalRecord);
+        header->committed_   = 0;
+        return true;
+    }
+
+    auto CommandJournal::Append(const Command &command) -> bool {
+        if (!base_) {
+            return false;
+        }
+        if (size_ == capacity_) {
+            // Keep the committed prefix durable before the map moves
+            if (!Commit() || !Map(capacity_ * 2)) {
+                return false;
+            }
+        }
+        Records()[size_] = JournalRecord{size_ + 1, Now(), command};
+        ++size_;
+        if (size_ - committed_ >= commit_every_) {
+            return Commit();
+        }
+        return true;
+    }
+
+    auto CommandJournal::Commit() -> bool {
+        if (!base_ || committed_ == size_) {
+            return base_ != nullptr;
+        }
+        static const auto page_size = static_cast<std::size_t>(::sysconf(_SC_PAGESIZE));
+
+        std::size_t begin = FileLength(committed_) & ~(page_size - 1);
+        std::size_t end   = FileLength(size_);
+        // Records first, then the count that makes them visible, so the header never covers a
+        // record that is not on disk yet
+        if (::msync(base_ + begin, end - begin, MS_SYNC) != 0) {
+            LOG_ERROR("Journal msync failed at record {}", committed_ + 1);
+            return false;
+        }
+        reinterpret_cast<JournalHeader *>(base_)->committed_ = size_;
+        if (::msync(base_, sizeof(JournalHeader), MS_SYNC) != 0) {
+            LOG_ERROR("Journal header msync failed at record {}", size_);
+            return false;
+        }
+        committed_ = size_;
+        return true;
+    }
+
+    auto CommandJournal::Close() -> void {
+        if (base_) {
+            Commit();
+        }
+        Unmap();
+        if (fd_ >= 0) {
+            ::close(fd_);
+            fd_ = -1;
+        }
+        size_      = 0;
+        committed_ = 0;
+    }
+
+    auto CommandJournal::IsOpen() const -> bool {
+        return base_ != nullptr;
+    }
+
+    auto CommandJournal::Size() const -> std::size_t {
+        return size_;
+    }
+
+    auto CommandJournal::Committed() const -> std::size_t {
+        return committed_;
+    }
+
+    auto CommandJournal::Map(std::size_t capacity) -> bool {
+        Unmap();
+        std::size_t length = FileLength(capacity);
+        struct stat status {};
+        ::fstat(fd_, &status);
+        if (static_cast<std::size_t>(status.st_size) < length && ::ftruncate(fd_, static_cast<off_t>(length)) != 0) {
+            LOG_ERROR("Can't grow journal to {} records", capacity);
+            return false;
+        }
+        void *base = ::mmap(nullptr, length, PROT_READ | PROT_WRITE, MAP_SHARED, fd_, 0);
+        if (base == MAP_FAILED) {
+            LOG_ERROR("Can't map journal of {} records", capacity);
+            return false;
+        }
+        base_     = static_cast<std::byte *>(base);
+        capacity_ = capacity;
+        return true;
+    }
+
+    auto CommandJournal::Unmap() -> void {
+        if (base_) {
+            ::munmap(base_, FileLength(capacity_));
+            base_     = nullptr;
+            capacity_ = 0;
+        }
+    }
+
+    auto CommandJournal::Records() const -> JournalRecord * {
+        return reinterpret_cast<JournalRecord *>(base_ + sizeof(JournalHeader));
+    }
+
+    JournalReader::~JournalReader() {
+        Close();
+    }
+
+    auto JournalReader::Open(const std::string &file_name) -> bool {
+        Close();
+        int fd = ::open(file_name.c_str(), O_RDONLY);
+        if (fd < 0) {
+            LOG_ERROR("Can't open journal {}", file_name);
+            return false;
+        }
+        struct stat status {};
+        ::fstat(fd, &status);
+        auto length = static_cast<std::size_t>(status.st_size);
+        if (length < sizeof(JournalHeader)) {
+            ::close(fd);
+            LOG_ERROR("{} is not a journal", file_name);
+            return false;
+        }
+        void *base = ::mmap(nullptr, length, PROT_READ, MAP_SHARED, fd, 0);
+        ::close(fd);
+        if (base == MAP_FAILED) {
+            LOG_ERROR("Can't map journal {}", file_name);
+            return false;
+        }
+        base_   = static_cast<const std::byte *>(base);
+        length_ = length;
+
+        const auto *header = reinterpret_cast<const JournalHeader *>(base_);
+        if (std::memcmp(header->magic_, JOURNAL_MAGIC, sizeof(JOURNAL_MAGIC)) != 0 ||
+            header->version_ != JOURNAL_VERSION || header->record_size_ != sizeof(JournalRecord)) {
+            LOG_ERROR("{} is not a journal", file_name);
+            Close();
+            return false;
+        }
+        ::madvise(const_cast<std::byte *>(base_), length_, MADV_SEQUENTIAL);
+        std::size_t records = (length_ - sizeof(JournalHeader)) / sizeof(JournalRecord);
+        size_               = ValidRecords(begin(), std::min<std::size_t>(header->committed_, records));
+        return true;
+    }
+
+    auto JournalReader::Close() -> void {
+        if (base_) {
+            ::munmap(const_cast<std::byte *>(base_), length_);
+            base_   = nullptr;
+            length_ = 0;
+            size_   = 0;
+        }
+    }
+
+    auto JournalReader::Size() const -> std::size_t {
+        return size_;
+    }
+
+    auto JournalReader::At(std::size_t index) const -> const JournalRecord & {
+        return begin()[index];
+    }
+
+    auto JournalReader::begin() const -> const JournalRecord * {
+        return reinterpret_cast<const JournalRecord *>(base_ + sizeof(JournalHeader));
+    }
+
+    auto JournalReader::end() const -> const JournalRecord * {
+        return begin() + size_;
+    }
+}    // namespace lhft::me
@@ -0,0 +1,154 @@
+#include <latency.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <thread>
+
+namespace lhft::perf {
+    auto ProbeName(Probe probe) -> const char * {
+        switch (probe) {
+            case Probe::DECODE:
+                return "decode";
+            case Probe::LOOKUP:
+                return "lookup";
+            case Probe::MATCH:
+                return "match";
+            case Probe::CALLBACK:
+                return "callback";
+            case Probe::ADD:
+                return "add";
+            case Probe::ADD_FILL:
+                return "add with fill";
+            case Probe::CANCEL:
+                return "cancel";
+            case Probe::COUNT:
+                break;
+        }
+        return "unknown";
+    }
+
+    auto TscClock::NsPerTick() -> double {
+        static const double ns_per_tick = [] {
+            auto start_time  = std::chrono::steady_clock::now();
+            auto start_ticks = Now();
+            std::this_thread::sleep_for(std::chrono::milliseconds(20));
+            auto ticks = Now() - start_ticks;
+            auto ns    = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start_time);
+            return ticks ? ns.count() / static_cast<double>(ticks) : 1.0;
+        }();
+        return ns_per_tick;
+    }
+
+    auto Histogram::Merge(const Histogram &other) -> void {
+        for (std::size_t index = 0; index < BUCKETS; ++index) {
+            Bump(counts_[index], other.counts_[index].load(std::memory_order_relaxed));
+        }
+        Bump(total_, other.total_.load(std::memory_order_relaxed));
+        auto other_max = other.max_.load(std::memory_order_relaxed);
+        if (other_max > max_.load(std::memory_order_relaxed)) {
+            max_.store(other_max, std::memory_order_relaxed);
+        }
+    }
+
+    auto Histogram::Reset() -> void {
+        for (auto &count : counts_) {
+            count.store(0, std::memory_order_relaxed);
+        }
+        total_.store(0, std::memory_order_relaxed);
+        max_.store(0, std::memory_order_relaxed);
+    }
+
+    auto Histogram::Count() const -> uint64_t {
+        return total_.load(std::memory_order_relaxed);
+    }
+
+    auto Histogram::Max() const -> uint64_t {
+        return max_.load(std::memory_order_relaxed);
+    }
+
+    auto Histogram::Percentile(double percentile) const -> uint64_t {
+        // Buckets are read one by one while the writer goes on, so count them up rather than trust
+        // total_
+        uint64_t total = 0;
+        for (const auto &count : counts_) {
+            total += count.load(std::memory_order_relaxed);
+        }
+        auto     target = static_cast<uint64_t>(percentile / 100.0 * static_cast<double>(total));
+        uint64_t seen   = 0;
+        for (std::size_t index = 0; index < BUCKETS; ++index) {
+            seen += counts_[index].load(std::memory_order_relaxed);
+            if (seen > target) {
+                return std::min(UpperBound(index), Max());
+            }
+        }
+        return Max();
+    }
+
+    auto Histogram::UpperBound(std::size_t index) -> uint64_t {
+        if (index < SUB_BUCKETS) {
+            return index;
+        }
+        std::size_t shift = index / SUB_BUCKETS - 1;
+        uint64_t    lower = (SUB_BUCKETS + index % SUB_BUCKETS) << shift;
+        return lower + ((uint64_t{1} << shift) - 1);
+    }
+
+    auto LatencyRegistry::Instance() -> LatencyRegistry & {
+        static LatencyRegistry registry;
+        return registry;
+    }
+
+    LatencyRegistry::~LatencyRegistry() {
+        if (dump_on_exit_) {
+            Dump(std::cout);
+        }
+    }
+
+    auto LatencyRegistry::Collect(Probe probe, Histogram &result) const -> void {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (const auto &histograms : histograms_) {
+            result.Merge((*histograms)[static_cast<std::size_t>(probe)]);
+        }
+    }
+
+    auto LatencyRegistry::Dump(std::ostream &os) const -> void {
+        double ns_per_tick = TscClock::NsPerTick();
+        auto   to_ns       = [ns_per_tick](uint64_t ticks) { return static_cast<double>(ticks) * ns_per_tick; };
+        auto   flags       = os.flags();
+        os << std::fixed << std::setprecision(0);
+        for (std::size_t index = 0; index < static_cast<std::size_t>(Probe::COUNT); ++index) {
+            auto probe     = static_cast<Probe>(index);
+            auto histogram = std::make_unique<Histogram>();
+            Collect(probe, *histogram);
+            if (histogram->Count() == 0) {
+                continue;
+            }
+            os << std::left << std::setw(14) << ProbeName(probe) << std::right << " count " << histogram->Count()
+               << " p50 " << to_ns(histogram->Percentile(50)) << "ns p99 " << to_ns(histogram->Percentile(99))
+               << "ns p99.9 " << to_ns(histogram->Percentile(99.9)) << "ns max " << to_ns(histogram->Max())
+               << "ns\n";
+        }
+        os.flags(flags);
+    }
+
+    auto LatencyRegistry::Reset() -> void {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (auto &histograms : histograms_) {
+            for (auto &histogram : *histograms) {
+                histogram.Reset();
+            }
+        }
+    }
+
+    auto LatencyRegistry::SetDumpOnExit(bool dump_on_exit) -> void {
+        dump_on_exit_ = dump_on_exit;
+    }
+
+    auto LatencyRegistry::Local() -> Histogram * {
+        std::lock_guard<std::mutex> lock(mutex_);
+        histograms_.push_back(std::make_unique<ProbeHistograms>());
+        return histograms_.back()->data();
+    }
+}    // namespace lhft::perf
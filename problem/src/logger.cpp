@@ -0,0 +1,221 @@
+#include "logger.hpp"
+
+#include <chrono>
+#include <iostream>
+
+namespace lhft::log {
+    namespace {
+        constexpr std::size_t RING_CAPACITY = 1 << 20;
+
+        constexpr auto IDLE_SLEEP = std::chrono::microseconds(100);
+
+        auto LevelName(Level level) -> const char * {
+            switch (level) {
+                case Level::DEBUG:
+                    return "DEBUG";
+                case Level::INFO:
+                    return "INFO";
+                case Level::ERROR:
+                    return "ERROR";
+                default:
+                    return "";
+            }
+        }
+    }    // namespace
+
+    LogRing::LogRing(std::size_t capacity) : buffer_(capacity), mask_(capacity - 1) {
+    }
+
+    auto LogRing::Reserve(std::size_t size) -> std::byte * {
+        std::size_t head     = head_.load(std::memory_order_relaxed);
+        std::size_t position = head & mask_;
+        // A record never wraps, the tail end of the buffer is skipped with a padding record instead
+        std::size_t padding = position + size > buffer_.size() ? buffer_.size() - position : 0;
+        std::size_t needed  = padding + size;
+        if (needed > buffer_.size()) {
+            return nullptr;
+        }
+        if (head + needed - cached_tail_ > buffer_.size()) {
+            cached_tail_ = tail_.load(std::memory_order_acquire);
+            if (head + needed - cached_tail_ > buffer_.size()) {
+                return nullptr;
+            }
+        }
+        if (padding) {
+            uint32_t marker[2] = {static_cast<uint32_t>(padding), 1};
+            std::memcpy(&buffer_[position], marker, sizeof(marker));
+            position = 0;
+        }
+        pending_ = needed;
+        return &buffer_[position];
+    }
+
+    auto LogRing::Commit() -> void {
+        head_.store(head_.load(std::memory_order_relaxed) + pending_, std::memory_order_release);
+        pending_ = 0;
+    }
+
+    auto LogRing::Peek() -> const std::byte * {
+        std::size_t tail = tail_.load(std::memory_order_relaxed);
+        std::size_t head = head_.load(std::memory_order_acquire);
+        while (tail != head) {
+            const std::byte *record = &buffer_[tail & mask_];
+            uint32_t         marker[2];
+            std::memcpy(marker, record, sizeof(marker));
+            if (!marker[1]) {
+                return record;
+            }
+            tail += marker[0];
+            tail_.store(tail, std::memory_order_release);
+        }
+        return nullptr;
+    }
+
+    auto LogRing::Pop(std::size_t size) -> void {
+        tail_.store(tail_.load(std::memory_order_relaxed) + size, std::memory_order_release);
+    }
+
+    auto LogRing::Empty() const -> bool {
+        return tail_.load(std::memory_order_acquire) == head_.load(std::memory_order_acquire);
+    }
+
+    auto LogRing::Drop() -> void {
+        dropped_.store(dropped_.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    }
+
+    auto LogRing::Dropped() const -> std::size_t {
+        return dropped_.load(std::memory_order_relaxed);
+    }
+
+    auto LogRing::Retire() -> void {
+        retired_.store(true, std::memory_order_release);
+    }
+
+    auto LogRing::Retired() const -> bool {
+        return retired_.load(std::memory_order_acquire);
+    }
+
+    auto Logger::Instance() -> Logger & {
+        static Logger logger;
+        return logger;
+    }
+
+    Logger::Logger() : out_(&std::cout), backend_([this] { Run(); }) {
+    }
+
+    Logger::~Logger() {
+        running_.store(false, std::memory_order_release);
+        backend_.join();
+    }
+
+    auto Logger::SetLevel(Level level) -> void {
+        level_.store(level, std::memory_order_relaxed);
+    }
+
+    auto Logger::GetLevel() const -> Level {
+        return level_.load(std::memory_order_relaxed);
+    }
+
+    auto Logger::Enabled(Level level) const -> bool {
+        return level >= level_.load(std::memory_order_relaxed);
+    }
+
+    auto Logger::Open(const std::string &file_name) -> bool {
+        // Whatever is already queued still goes to the previous stream
+        Flush();
+        std::lock_guard lock(mutex_);
+        file_.close();
+        file_.open(file_name, std::ios::out | std::ios::trunc);
+        out_ = file_.is_open() ? static_cast<std::ostream *>(&file_) : &std::cout;
+        return file_.is_open();
+    }
+
+    auto Logger::Flush() -> void {
+        // Records are only popped once written, so empty rings mean everything reached the stream
+        for (;;) {
+            {
+                std::lock_guard lock(mutex_);
+                bool            empty = true;
+                for (const auto &ring : rings_) {
+                    empty = empty && ring->Empty();
+                }
+                if (empty) {
+                    out_->flush();
+                    return;
+                }
+            }
+            std::this_thread::yield();
+        }
+    }
+
+    auto Logger::Dropped() const -> std::size_t {
+        std::lock_guard lock(mutex_);
+        std::size_t     dropped = retired_dropped_;
+        for (const auto &ring : rings_) {
+            dropped += ring->Dropped();
+        }
+        return dropped;
+    }
+
+    auto Logger::Rings() const -> std::size_t {
+        std::lock_guard lock(mutex_);
+        return rings_.size();
+    }
+
+    auto Logger::LocalRing() -> LogRing & {
+        // Owned by the logger so that records of an exited thread are still drained; the thread only
+        // marks it retired on exit and Drain releases it once empty
+        struct RingOwner {
+            LogRing *ring_{nullptr};
+
+            ~RingOwner() {
+                if (ring_) {
+                    ring_->Retire();
+                }
+            }
+        };
+        thread_local RingOwner owner;
+        if (!owner.ring_) {
+            std::lock_guard lock(mutex_);
+            owner.ring_ = rings_.emplace_back(std::make_unique<LogRing>(RING_CAPACITY)).get();
+        }
+        return *owner.ring_;
+    }
+
+    auto Logger::Run() -> void {
+        while (running_.load(std::memory_order_acquire)) {
+            if (!Drain()) {
+                std::this_thread::sleep_for(IDLE_SLEEP);
+            }
+        }
+        Drain();
+    }
+
+    auto Logger::Drain() -> bool {
+        std::lock_guard lock(mutex_);
+        bool            written = false;
+        for (auto ring = rings_.begin(); ring != rings_.end();) {
+            // Read first: a ring retired by now holds every record its thread will ever write
+            bool retired = (*ring)->Retired();
+            while (const std::byte *record = (*ring)->Peek()) {
+                RecordHeader header;
+                std::memcpy(&header, record, sizeof(header));
+                *out_ << LevelName(header.level_) << ": ";
+                header.decode_(*out_, header.format_, record + sizeof(header));
+                *out_ << '\n';
+                (*ring)->Pop(header.size_);
+                written = true;
+            }
+            if (retired) {
+                retired_dropped_ += (*ring)->Dropped();
+                ring = rings_.erase(ring);
+            } else {
+                ++ring;
+            }
+        }
+        if (written) {
+            out_->flush();
+        }
+        return written;
+    }
+}    // namespace lhft::log
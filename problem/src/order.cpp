@@ -1,6 +1,15 @@
+#include <algorithm>
 #include <order.hpp>
 
 namespace lhft::book {
+    namespace {
+        auto PricedChange(State state, Quantity quantity, Price price) -> StateChange {
+            StateChange change(state, quantity);
+            change.price_ = price;
+            return change;
+        }
+    }    // namespace
+
     Order::Order(OrderId id, bool buy_side, Symbol symbol, Quantity quantity, Price price)
         : id_{id}, buy_side_{buy_side}, symbol_{symbol}, quantity_{quantity}, price_{price} {
     }
@@ -41,6 +50,58 @@ namespace lhft::book {
         return fill_cost_;
     }
 
+    auto Order::GetBookHandle() const -> OrderHandle {
+        return book_handle_;
+    }
+
+    auto Order::SetBookHandle(OrderHandle handle) -> void {
+        book_handle_ = handle;
+    }
+
+    auto Order::GetStopPrice() const -> Price {
+        return stop_price_;
+    }
+
+    auto Order::SetStopPrice(Price stop_price) -> void {
+        stop_price_ = stop_price;
+    }
+
+    auto Order::IsStop() const -> bool {
+        return stop_price_ != 0;
+    }
+
+    auto Order::IsTriggered() const -> bool {
+        return triggered_;
+    }
+
+    auto Order::SetTriggered(bool triggered) -> void {
+        triggered_ = triggered;
+    }
+
+    auto Order::GetTimeInForce() const -> TimeInForce {
+        return time_in_force_;
+    }
+
+    auto Order::SetTimeInForce(TimeInForce time_in_force) -> void {
+        time_in_force_ = time_in_force;
+    }
+
+    auto Order::IsPostOnly() const -> bool {
+        return post_only_;
+    }
+
+    auto Order::SetPostOnly(bool post_only) -> void {
+        post_only_ = post_only;
+    }
+
+    auto Order::GetOwner() const -> Owner {
+        return owner_;
+    }
+
+    auto Order::SetOwner(Owner owner) -> void {
+        owner_ = owner;
+    }
+
     auto Order::GetHistory() const -> const History & {
         return history_;
     }
@@ -50,44 +111,40 @@ namespace lhft::book {
     }
 
     auto Order::CurrentState() const -> std::optional<StateChange> {
-        if (!history_.empty()) {
-            return history_.back();
+        if (last_event_.state_ != State::UNKNOWN) {
+            return last_event_;
         }
         return {};
     }
 
     auto Order::OnSubmitted() -> void {
-        std::stringstream msg;
-        msg << (IsBuy() ? "BUY " : "SELL ") << quantity_ << ' ' << symbol_ << " @";
-        if (price_ == 0) {
-            msg << "MKT";
-        } else {
-            msg << price_;
-        }
-        history_.emplace_back(State::SUBMITTED, msg.str());
+        auto change      = PricedChange(State::SUBMITTED, quantity_, price_);
+        change.symbol_   = symbol_;
+        change.buy_side_ = buy_side_;
+        Record(change);
     }
 
     auto Order::OnAccepted() -> void {
         quantity_on_market_ = quantity_;
-        history_.emplace_back(State::ACCEPTED);
+        Record(StateChange(State::ACCEPTED));
     }
 
     auto Order::OnRejected(const char *reason) -> void {
-        history_.emplace_back(State::REJECTED, reason);
+        Record(StateChange(State::REJECTED, 0, 0, reason));
     }
 
     auto Order::OnFilled(Quantity fill_qty, Cost fill_cost) -> void {
         quantity_on_market_ -= fill_qty;
         fill_cost_ += fill_cost;
         quantity_filled_ += fill_qty;
-
-        std::stringstream msg;
-        msg << fill_qty << " for " << fill_cost;
-        history_.emplace_back(State::FILLED, msg.str());
+        Record(StateChange(State::FILLED, fill_qty, fill_cost));
     }
 
     auto Order::AddTradeHistory(Quantity fill_qty, Quantity remaining_qty, Cost fill_cost,
                                 const OrderId &matched_order_id, Price price, FillId fill_id) -> void {
+        if (lean_) {
+            return;
+        }
         MatchedTrade res{};
         res.matched_order_id_   = matched_order_id;
         res.fill_cost_          = fill_cost;
@@ -98,29 +155,41 @@ namespace lhft::book {
         trades_.emplace_back(res);
     }
 
+    auto Order::OnRestored(Quantity quantity_on_market, Quantity quantity_filled, Cost fill_cost) -> void {
+        quantity_on_market_ = quantity_on_market;
+        quantity_filled_    = quantity_filled;
+        fill_cost_          = fill_cost;
+        Record(StateChange(State::ACCEPTED, 0, 0, "restored"));
+    }
+
     auto Order::OnCancelRequested() -> void {
-        history_.emplace_back(State::CANCEL_REQUESTED);
+        Record(StateChange(State::CANCEL_REQUESTED));
     }
 
     auto Order::OnCancelled() -> void {
         quantity_on_market_ = 0;
-        history_.emplace_back(State::CANCELLED);
+        Record(StateChange(State::CANCELLED));
     }
 
     auto Order::OnCancelRejected(const char *reason) -> void {
-        history_.emplace_back(State::CANCEL_REJECTED, reason);
+        Record(StateChange(State::CANCEL_REJECTED, 0, 0, reason));
     }
 
     auto Order::OnReplaceRequested(const int64_t &size_delta, Price new_price) -> void {
-        // TODO
+        Record(PricedChange(State::MODIFY_REQUESTED, quantity_ + size_delta, new_price));
     }
 
     auto Order::OnReplaced(const int64_t &size_delta, Price new_price) -> void {
-        // TODO
+        quantity_ += size_delta;
+        quantity_on_market_ += size_delta;
+        if (new_price != PRICE_UNCHANGED) {
+            price_ = new_price;
+        }
+        Record(PricedChange(State::MODIFIED, quantity_, price_));
     }
 
     auto Order::OnReplaceRejected(const char *reason) -> void {
-        // TODO
+        Record(StateChange(State::MODIFY_REJECTED, 0, 0, reason));
     }
 
     auto Order::GetOrderData(OrderData &order_data, State state, const std::string &reason) -> void {
@@ -139,44 +208,64 @@ namespace lhft::book {
         order_data.reason_ = reason;
     }
 
-    std::ostream &operator<<(std::ostream &os, const Order &order) {
-        os << "[#" << order.GetOrderId();
-        os << ' ' << (order.IsBuy() ? "BUY" : "SELL");
-        os << ' ' << order.GetSymbol();
-        os << ' ' << order.OrderQty();
-        if (order.GetPrice() == 0) {
-            os << " MKT";
-        } else {
-            os << " $" << order.GetPrice();
-        }
+    namespace {
+        auto PrintOrder(std::ostream &os, const OrderSnapshot &order) -> void {
+            os << "[#" << order.id_;
+            os << ' ' << (order.buy_side_ ? "BUY" : "SELL");
+            os << ' ' << order.symbol_;
+            os << ' ' << order.quantity_;
+            if (order.price_ == 0) {
+                os << " MKT";
+            } else {
+                os << " $" << order.price_;
+            }
 
-        auto on_market = order.QuantityOnMarket();
-        if (on_market != 0) {
-            os << " Open: " << on_market;
-        }
+            if (order.quantity_on_market_ != 0) {
+                os << " Open: " << order.quantity_on_market_;
+            }
+
+            if (order.quantity_filled_ != 0) {
+                os << " FILLED: " << order.quantity_filled_;
+            }
 
-        auto filled = order.QuantityFilled();
-        if (filled != 0) {
-            os << " FILLED: " << filled;
+            if (order.fill_cost_ != 0) {
+                os << " Cost: " << order.fill_cost_;
+            }
         }
+    }    // namespace
 
-        auto cost = order.FillCost();
-        if (cost != 0) {
-            os << " Cost: " << cost;
+    std::ostream &operator<<(std::ostream &os, const Order &order) {
+        OrderSnapshot snapshot(order);
+        if (!order.IsVerbose()) {
+            return os << snapshot;
         }
 
-        if (order.IsVerbose()) {
-            const Order::History &history = order.GetHistory();
-            for (const auto &event : history) {
-                os << "\n\t" << event;
-            }
-        } else {
-            auto cur_state = order.CurrentState();
-            if (cur_state) {
-                os << " Last Event: " << *cur_state;
-            }
+        PrintOrder(os, snapshot);
+        for (const auto &event : order.GetHistory()) {
+            os << "\n\t" << event;
         }
+        os << ']';
 
+        return os;
+    }
+
+    OrderSnapshot::OrderSnapshot(const Order &order)
+        : id_(order.GetOrderId()),
+          buy_side_(order.IsBuy()),
+          symbol_(order.GetSymbol()),
+          quantity_(order.OrderQty()),
+          price_(order.GetPrice()),
+          quantity_on_market_(order.QuantityOnMarket()),
+          quantity_filled_(order.QuantityFilled()),
+          fill_cost_(order.FillCost()),
+          last_event_(order.CurrentState().value_or(StateChange())) {
+    }
+
+    std::ostream &operator<<(std::ostream &os, const OrderSnapshot &snapshot) {
+        PrintOrder(os, snapshot);
+        if (snapshot.last_event_.state_ != State::UNKNOWN) {
+            os << " Last Event: " << snapshot.last_event_;
+        }
         os << ']';
 
         return os;
@@ -185,4 +274,72 @@ namespace lhft::book {
     auto Order::IsVerbose() const -> bool {
         return verbose_;
     }
+
+    auto Order::SetLean(bool lean) -> void {
+        lean_ = lean;
+    }
+
+    auto Order::IsLean() const -> bool {
+        return lean_;
+    }
+
+    auto Order::Record(const StateChange &change) -> void {
+        last_event_ = change;
+        if (!lean_) {
+            history_.Push(change);
+        }
+    }
+
+    auto OrderHistory::Push(const StateChange &change) -> void {
+        events_[next_] = change;
+        next_          = (next_ + 1) % events_.size();
+        size_          = (std::min)(size_ + 1, events_.size());
+    }
+
+    auto OrderHistory::Size() const -> std::size_t {
+        return size_;
+    }
+
+    auto OrderHistory::Empty() const -> bool {
+        return size_ == 0;
+    }
+
+    auto OrderHistory::operator[](std::size_t index) const -> const StateChange & {
+        return events_[(next_ + events_.size() - size_ + index) % events_.size()];
+    }
+
+    auto OrderHistory::begin() const -> const_iterator {
+        return const_iterator(this, 0);
+    }
+
+    auto OrderHistory::end() const -> const_iterator {
+        return const_iterator(this, size_);
+    }
+
+    std::ostream &operator<<(std::ostream &os, const StateChange &change) {
+        os << " Description: ";
+        switch (change.state_) {
+            case State::SUBMITTED:
+                os << (change.buy_side_ ? "BUY " : "SELL ") << change.quantity_ << ' ' << change.symbol_ << " @";
+                if (change.price_ == 0) {
+                    os << "MKT";
+                } else {
+                    os << change.price_;
+                }
+                break;
+            case State::FILLED:
+                os << change.quantity_ << " for " << change.cost_;
+                break;
+            case State::MODIFY_REQUESTED:
+            case State::MODIFIED:
+                os << change.quantity_ << " @" << change.price_;
+                break;
+            default:
+                if (change.reason_) {
+                    os << change.reason_;
+                }
+                break;
+        }
+        return os;
+    }
 }    // namespace lhft::book
\ No newline at end of file
@@ -0,0 +1,134 @@
+#include <order_entry.hpp>
+
+namespace lhft::me {
+    namespace {
+        template <typename Message>
+        auto Load(const std::byte *data) -> Message {
+            Message message;
+            std::memcpy(&message, data, sizeof(Message));
+            return message;
+        }
+    }    // namespace
+
+    auto MessageEncoder::AddOrder(uint64_t order_id, Side side, uint32_t symbol, uint32_t quantity, uint64_t price,
+                                  OrderType order_type, book::TimeInForce time_in_force, bool post_only,
+                                  uint64_t stop_price, uint32_t owner) -> void {
+        AddOrderMessage message;
+        message.order_id_      = order_id;
+        message.symbol_        = symbol;
+        message.price_         = price;
+        message.quantity_      = quantity;
+        message.side_          = side;
+        message.order_type_    = order_type;
+        message.time_in_force_ = time_in_force;
+        message.post_only_     = post_only;
+        message.stop_price_    = stop_price;
+        message.owner_         = owner;
+        Append(message);
+    }
+
+    auto MessageEncoder::CancelOrder(uint64_t order_id, uint32_t symbol) -> void {
+        CancelOrderMessage message;
+        message.order_id_ = order_id;
+        message.symbol_   = symbol;
+        Append(message);
+    }
+
+    auto MessageEncoder::ReplaceOrder(uint64_t order_id, uint32_t symbol, uint32_t quantity, uint64_t price) -> void {
+        ReplaceOrderMessage message;
+        message.order_id_ = order_id;
+        message.symbol_   = symbol;
+        message.price_    = price;
+        message.quantity_ = quantity;
+        Append(message);
+    }
+
+    auto MessageEncoder::MassCancel(uint32_t symbol, Side side, uint32_t owner) -> void {
+        MassCancelMessage message;
+        message.symbol_ = symbol;
+        message.side_   = side;
+        message.owner_  = owner;
+        Append(message);
+    }
+
+    auto MessageEncoder::Data() const -> const std::byte * {
+        return buffer_.data();
+    }
+
+    auto MessageEncoder::Size() const -> std::size_t {
+        return buffer_.size();
+    }
+
+    auto MessageEncoder::Clear() -> void {
+        buffer_.clear();
+    }
+
+    auto MessageDecoder::Errors() const -> std::size_t {
+        return errors_;
+    }
+
+    auto MessageDecoder::Broken() const -> bool {
+        return broken_;
+    }
+
+    auto MessageDecoder::ToCommand(const std::byte *message, MessageType type, std::size_t length,
+                                   Command &command) const -> bool {
+        switch (type) {
+            case MessageType::ADD_ORDER: {
+                if (length != sizeof(AddOrderMessage)) {
+                    return false;
+                }
+                auto add = Load<AddOrderMessage>(message);
+                if ((add.side_ != Side::BUY && add.side_ != Side::SELL) ||
+                    (add.order_type_ == OrderType::LIMIT && add.price_ == book::MARKET_ORDER_PRICE) ||
+                    (add.order_type_ != OrderType::LIMIT && add.order_type_ != OrderType::MARKET) ||
+                    add.time_in_force_ > book::TimeInForce::FOK) {
+                    return false;
+                }
+                command = Command{CommandType::SUBMIT,
+                                  add.order_id_,
+                                  add.side_ == Side::BUY,
+                                  add.symbol_,
+                                  add.quantity_,
+                                  add.order_type_ == OrderType::MARKET ? book::MARKET_ORDER_PRICE : add.price_,
+                                  add.time_in_force_,
+                                  add.post_only_,
+                                  add.stop_price_};
+                command.owner_ = add.owner_;
+                return true;
+            }
+            case MessageType::CANCEL_ORDER: {
+                if (length != sizeof(CancelOrderMessage)) {
+                    return false;
+                }
+                auto cancel = Load<CancelOrderMessage>(message);
+                command     = Command{CommandType::CANCEL, cancel.order_id_, false, cancel.symbol_, 0, 0};
+                return true;
+            }
+            case MessageType::REPLACE_ORDER: {
+                if (length != sizeof(ReplaceOrderMessage)) {
+                    return false;
+                }
+                auto replace = Load<ReplaceOrderMessage>(message);
+                command      = Command{CommandType::REPLACE, replace.order_id_, false, replace.symbol_,
+                                  replace.quantity_, replace.price_};
+                return true;
+            }
+            case MessageType::MASS_CANCEL: {
+                if (length != sizeof(MassCancelMessage)) {
+                    return false;
+                }
+                auto cancel = Load<MassCancelMessage>(message);
+                if (cancel.side_ != Side::BUY && cancel.side_ != Side::SELL && cancel.side_ != Side::BOTH) {
+                    return false;
+                }
+                command              = Command{CommandType::MASS_CANCEL, 0, false, cancel.symbol_, 0, 0};
+                command.owner_       = cancel.owner_;
+                command.cancel_bids_ = cancel.side_ != Side::SELL;
+                command.cancel_asks_ = cancel.side_ != Side::BUY;
+                return true;
+            }
+        }
+        return false;
+    }
+}    // namespace lhft::me
@@ -0,0 +1,169 @@
+#include <order_file.hpp>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cstring>
+
+#include "latency.hpp"
+#include "logger.hpp"
+
+namespace lhft::me {
+    namespace {
+        // Reads the decimal at pos and steps over the ',' that ends it. Fails on an empty field or
+        // on anything but a digit before the delimiter
+        auto ParseNumber(const char *&pos, const char *end, std::size_t &value) -> bool {
+            const char *start  = pos;
+            std::size_t result = 0;
+            while (pos != end) {
+                auto digit = static_cast<unsigned>(*pos) - '0';
+                if (digit > 9) {
+                    break;
+                }
+                result = result * 10 + digit;
+                ++pos;
+            }
+            value = result;
+            if (pos == start) {
+                return false;
+            }
+            if (pos == end) {
+                return true;
+            }
+            return *pos++ == ',';
+        }
+
+        auto ParseChar(const char *&pos, const char *end, char &value) -> bool {
+            if (end - pos < 1) {
+                return false;
+            }
+            value = *pos++;
+            if (pos == end) {
+                return true;
+            }
+            return *pos++ == ',';
+        }
+    }    // namespace
+
+    MappedFile::~MappedFile() {
+        Close();
+    }
+
+    auto MappedFile::Open(const std::string &file_name) -> bool {
+        Close();
+        int fd = ::open(file_name.c_str(), O_RDONLY);
+        if (fd < 0) {
+            LOG_ERROR("Can't open {}", file_name);
+            return false;
+        }
+        struct stat status {};
+        ::fstat(fd, &status);
+        auto length = static_cast<std::size_t>(status.st_size);
+        if (length == 0) {
+            // Nothing to map, an empty file reads as empty data
+            ::close(fd);
+            return true;
+        }
+        void *base = ::mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+        ::close(fd);
+        if (base == MAP_FAILED) {
+            LOG_ERROR("Can't map {}", file_name);
+            return false;
+        }
+        ::madvise(base, length, MADV_SEQUENTIAL);
+        base_   = static_cast<const char *>(base);
+        length_ = length;
+        return true;
+    }
+
+    auto MappedFile::Close() -> void {
+        if (base_) {
+            ::munmap(const_cast<char *>(base_), length_);
+            base_   = nullptr;
+            length_ = 0;
+        }
+    }
+
+    auto MappedFile::IsOpen() const -> bool {
+        return base_ != nullptr;
+    }
+
+    auto MappedFile::Data() const -> std::string_view {
+        return {base_, length_};
+    }
+
+    OrderFileParser::OrderFileParser(std::string_view data, book::Symbol default_symbol)
+        : pos_(data.data()), end_(data.data() + data.size()), default_symbol_(default_symbol) {
+    }
+
+    auto OrderFileParser::Next(Command &command) -> bool {
+        while (pos_ != end_) {
+            // memchr scans a vector at a time, the line itself is then parsed in one pass
+            const auto *newline = static_cast<const char *>(std::memchr(pos_, '\n', end_ - pos_));
+            const char *line    = pos_;
+            const char *end     = newline ? newline : end_;
+            pos_                = newline ? newline + 1 : end_;
+            ++lines_;
+
+            while (end != line && (end[-1] == '\r' || end[-1] == ' ' || end[-1] == '\t')) {
+                --end;
+            }
+            if (end == line) {
+                continue;
+            }
+            LATENCY_START(decode);
+            bool parsed = ParseLine(line, end, command);
+            LATENCY_RECORD(perf::Probe::DECODE, decode);
+            if (parsed) {
+                return true;
+            }
+            LOG_ERROR("Invalid order line {}: {}", lines_, std::string_view(line, end - line));
+            ++errors_;
+        }
+        return false;
+    }
+
+    auto OrderFileParser::Next(Command *commands, std::size_t max) -> std::size_t {
+        std::size_t count = 0;
+        while (count < max && Next(commands[count])) {
+            ++count;
+        }
+        return count;
+    }
+
+    auto OrderFileParser::Lines() const -> std::size_t {
+        return lines_;
+    }
+
+    auto OrderFileParser::Errors() const -> std::size_t {
+        return errors_;
+    }
+
+    auto OrderFileParser::ParseLine(const char *pos, const char *end, Command &command) const -> bool {
+        char msg_type = '\0';
+        if (!ParseChar(pos, end, msg_type) || !ParseNumber(pos, end, command.order_id_)) {
+            return false;
+        }
+        switch (msg_type) {
+            case 'A': {
+                char side = '\0';
+                if (!ParseChar(pos, end, side) || (side != 'B' && side != 'S') ||
+                    !ParseNumber(pos, end, command.quantity_) || !ParseNumber(pos, end, command.price_)) {
+                    return false;
+                }
+                command.type_     = CommandType::SUBMIT;
+                command.buy_side_ = side == 'B';
+                command.symbol_   = default_symbol_;
+                return pos == end || (ParseNumber(pos, end, command.symbol_) && pos == end);
+            }
+            case 'X':
+                // Anything after the order id only echoes the original order
+                command.type_ = CommandType::CANCEL;
+                return true;
+            default:
+                return false;
+        }
+    }
+}    // namespace lhft::me
@@ -0,0 +1,6 @@
+#include <sharded_market.hpp>
+
+namespace lhft::me {
+    template class BasicShardedMarket<SharedOrders>;
+    template class BasicShardedMarket<PooledOrders>;
+}    // namespace lhft::me
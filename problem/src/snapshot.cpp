@@ -0,0 +1,57 @@
+#include <snapshot.hpp>
+
+#include <cstdio>
+
+namespace lhft::book {
+    namespace {
+        constexpr char     SNAPSHOT_MAGIC[8] = {'L', 'H', 'F', 'T', 'S', 'N', 'A', 'P'};
+        constexpr uint32_t SNAPSHOT_VERSION  = 5;
+    }    // namespace
+
+    auto SnapshotWriter::Save(const std::string &file_name) const -> bool {
+        std::FILE *file = std::fopen(file_name.c_str(), "wb");
+        if (!file) {
+            return false;
+        }
+        bool written = std::fwrite(buffer_.data(), 1, buffer_.size(), file) == buffer_.size();
+        return std::fclose(file) == 0 && written;
+    }
+
+    auto SnapshotReader::Load(const std::string &file_name) -> bool {
+        std::FILE *file = std::fopen(file_name.c_str(), "rb");
+        if (!file) {
+            return false;
+        }
+        std::fseek(file, 0, SEEK_END);
+        long length = std::ftell(file);
+        std::fseek(file, 0, SEEK_SET);
+        buffer_.resize(length > 0 ? static_cast<std::size_t>(length) : 0);
+        bool read = std::fread(buffer_.data(), 1, buffer_.size(), file) == buffer_.size();
+        std::fclose(file);
+        position_ = 0;
+        return read;
+    }
+
+    auto SnapshotReader::AtEnd() const -> bool {
+        return position_ == buffer_.size();
+    }
+
+    auto SnapshotReader::Remaining() const -> std::size_t {
+        return buffer_.size() - position_;
+    }
+
+    auto MakeSnapshotHeader(uint32_t books, uint64_t orders, uint64_t journal_seq_no) -> SnapshotHeader {
+        SnapshotHeader header;
+        std::memcpy(header.magic_, SNAPSHOT_MAGIC, sizeof(SNAPSHOT_MAGIC));
+        header.version_        = SNAPSHOT_VERSION;
+        header.books_          = books;
+        header.orders_         = orders;
+        header.journal_seq_no_ = journal_seq_no;
+        return header;
+    }
+
+    auto ValidSnapshotHeader(const SnapshotHeader &header) -> bool {
+        return std::memcmp(header.magic_, SNAPSHOT_MAGIC, sizeof(SNAPSHOT_MAGIC)) == 0 &&
+               header.version_ == SNAPSHOT_VERSION;
+    }
+}    // namespace lhft::book
@@ -0,0 +1,21 @@
+#include <thread_util.hpp>
+
+#ifdef __linux__
+#include <pthread.h>
+#endif
+
+namespace lhft::me {
+    auto PinThread(std::thread &thread, int core) -> bool {
+        if (core < 0) {
+            return false;
+        }
+#ifdef __linux__
+        cpu_set_t cpus;
+        CPU_ZERO(&cpus);
+        CPU_SET(core, &cpus);
+        return pthread_setaffinity_np(thread.native_handle(), sizeof(cpus), &cpus) == 0;
+#else
+        return false;
+#endif
+    }
+}    // namespace lhft::me
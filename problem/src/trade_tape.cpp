@@ -0,0 +1,134 @@
+#include <trade_tape.hpp>
+
+#include <algorithm>
+#include <bit>
+#include <chrono>
+
+#include "logger.hpp"
+
+namespace lhft::book {
+    namespace {
+        constexpr std::size_t WRITE_BATCH = 256;
+
+        constexpr auto IDLE_SLEEP = std::chrono::microseconds(100);
+    }    // namespace
+
+    TradeTape::TradeTape(std::size_t capacity, std::size_t readers)
+        : slots_(std::bit_ceil(capacity ? capacity : 1)),
+          mask_(slots_.size() - 1),
+          cursors_(std::make_unique<Cursor[]>(readers ? readers : 1)),
+          readers_(readers ? readers : 1) {
+    }
+
+    auto TradeTape::Append(const TradeData &trade) -> bool {
+        std::size_t seq_no = ++seq_no_;
+        std::size_t head   = head_.load(std::memory_order_relaxed);
+        if (head - cached_slowest_ == slots_.size()) {
+            cached_slowest_ = SlowestReader();
+            if (head - cached_slowest_ == slots_.size()) {
+                dropped_.store(dropped_.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+                return false;
+            }
+        }
+        TradeData &slot     = slots_[head & mask_];
+        slot                = trade;
+        slot.stream_header_ = StreamHeader{seq_no, TRADE_EVENT_TICK};
+        head_.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    auto TradeTape::Read(std::size_t reader, TradeData *out, std::size_t max) -> std::size_t {
+        auto &      cursor   = cursors_[reader].position_;
+        std::size_t position = cursor.load(std::memory_order_relaxed);
+        std::size_t count    = std::min(max, head_.load(std::memory_order_acquire) - position);
+        for (std::size_t index = 0; index < count; ++index) {
+            out[index] = slots_[(position + index) & mask_];
+        }
+        cursor.store(position + count, std::memory_order_release);
+        return count;
+    }
+
+    auto TradeTape::SeqNo() const -> std::size_t {
+        return seq_no_;
+    }
+
+    auto TradeTape::Dropped() const -> std::size_t {
+        return dropped_.load(std::memory_order_relaxed);
+    }
+
+    auto TradeTape::Capacity() const -> std::size_t {
+        return slots_.size();
+    }
+
+    auto TradeTape::Readers() const -> std::size_t {
+        return readers_;
+    }
+
+    auto TradeTape::SlowestReader() const -> std::size_t {
+        std::size_t slowest = cursors_[0].position_.load(std::memory_order_acquire);
+        for (std::size_t reader = 1; reader < readers_; ++reader) {
+            slowest = std::min(slowest, cursors_[reader].position_.load(std::memory_order_acquire));
+        }
+        return slowest;
+    }
+
+    TradeFileWriter::TradeFileWriter(TradeTape &tape, std::size_t reader)
+        : tape_(tape), reader_(reader), buffer_(WRITE_BATCH) {
+    }
+
+    TradeFileWriter::~TradeFileWriter() {
+        Stop();
+    }
+
+    auto TradeFileWriter::Start(const std::string &file_name) -> bool {
+        if (worker_.joinable()) {
+            return false;
+        }
+        file_ = std::fopen(file_name.c_str(), "wb");
+        if (!file_) {
+            LOG_ERROR("Can't open trade file {}", file_name);
+            return false;
+        }
+        running_.store(true, std::memory_order_release);
+        worker_ = std::thread([this] { Run(); });
+        return true;
+    }
+
+    auto TradeFileWriter::Stop() -> void {
+        running_.store(false, std::memory_order_release);
+        if (worker_.joinable()) {
+            worker_.join();
+        }
+        if (file_) {
+            std::fclose(file_);
+            file_ = nullptr;
+        }
+    }
+
+    auto TradeFileWriter::Written() const -> std::size_t {
+        return written_.load(std::memory_order_acquire);
+    }
+
+    auto TradeFileWriter::Run() -> void {
+        while (running_.load(std::memory_order_acquire)) {
+            if (!Drain()) {
+                std::this_thread::sleep_for(IDLE_SLEEP);
+            }
+        }
+        while (Drain()) {
+        }
+        std::fflush(file_);
+    }
+
+    auto TradeFileWriter::Drain() -> std::size_t {
+        std::size_t count = tape_.Read(reader_, buffer_.data(), buffer_.size());
+        if (count != 0) {
+            std::size_t written = std::fwrite(buffer_.data(), sizeof(TradeData), count, file_);
+            if (written != count) {
+                LOG_ERROR("Can't write {} trades", count - written);
+            }
+            written_.fetch_add(written, std::memory_order_release);
+        }
+        return count;
+    }
+}    // namespace lhft::book
@@ -0,0 +1,142 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <market.hpp>
+#include <order_file.hpp>
+#include <string>
+#include <vector>
+
+namespace {
+    using Clock = std::chrono::steady_clock;
+
+    // Per command latency in 1ns buckets, everything from MAX_NS up is kept in the last bucket
+    class LatencyStats {
+    public:
+        static constexpr std::size_t MAX_NS = 1 << 17;
+
+        auto Record(uint64_t ns) -> void {
+            ++buckets_[std::min<uint64_t>(ns, MAX_NS - 1)];
+            max_ = std::max(max_, ns);
+            ++count_;
+        }
+
+        [[nodiscard]] auto Percentile(double percentile) const -> uint64_t {
+            auto     target = static_cast<uint64_t>(percentile / 100.0 * static_cast<double>(count_));
+            uint64_t seen   = 0;
+            for (std::size_t ns = 0; ns < buckets_.size(); ++ns) {
+                seen += buckets_[ns];
+                if (seen > target) {
+                    return ns;
+                }
+            }
+            return max_;
+        }
+
+        [[nodiscard]] auto Max() const -> uint64_t {
+            return max_;
+        }
+
+        [[nodiscard]] auto Count() const -> uint64_t {
+            return count_;
+        }
+
+    private:
+        std::vector<uint64_t> buckets_ = std::vector<uint64_t>(MAX_NS);
+        uint64_t              max_{0};
+        uint64_t              count_{0};
+    };
+
+    struct Options {
+        std::string        file_name_;
+        std::size_t        batch_{lhft::book::COMMAND_BATCH_SIZE};
+        lhft::book::Symbol default_symbol_{lhft::book::DEFAULT_SYMBOL};
+        bool               verbose_{false};
+    };
+
+    auto Usage(const char *name) -> int {
+        std::cerr << "Usage: " << name << " [-b batch] [-s default symbol] [-v] <order file>\n";
+        return EXIT_FAILURE;
+    }
+
+    auto ParseOptions(int argc, char *argv[], Options &options) -> bool {
+        for (int index = 1; index < argc; ++index) {
+            std::string arg = argv[index];
+            if ((arg == "-b" || arg == "-s") && index + 1 < argc) {
+                auto value = std::strtoull(argv[++index], nullptr, 10);
+                (arg == "-b" ? options.batch_ : options.default_symbol_) = value;
+            } else if (arg == "-v") {
+                options.verbose_ = true;
+            } else if (options.file_name_.empty() && arg[0] != '-') {
+                options.file_name_ = arg;
+            } else {
+                return false;
+            }
+        }
+        return !options.file_name_.empty() && options.batch_ > 0;
+    }
+}    // namespace
+
+// Replays an order file through a PooledMarket and reports throughput and per command latency.
+// Books are created the first time a symbol is seen.
+int main(int argc, char *argv[]) {
+    using namespace lhft;
+
+    Options options;
+    if (!ParseOptions(argc, argv, options)) {
+        return Usage(argv[0]);
+    }
+    if (!options.verbose_) {
+        log::Logger::Instance().SetLevel(log::Level::ERROR);
+    }
+
+    me::MappedFile file;
+    if (!file.Open(options.file_name_)) {
+        std::cerr << "Can't read " << options.file_name_ << '\n';
+        return EXIT_FAILURE;
+    }
+
+    me::PooledMarket         market;
+    me::OrderFileParser      parser(file.Data(), options.default_symbol_);
+    std::vector<me::Command> commands(options.batch_);
+    LatencyStats             latency;
+    std::size_t              accepted = 0;
+
+    auto start = Clock::now();
+    while (std::size_t count = parser.Next(commands.data(), commands.size())) {
+        market.BeginBatch();
+        for (std::size_t index = 0; index < count; ++index) {
+            const me::Command &command = commands[index];
+            if (command.type_ == me::CommandType::SUBMIT && !market.FindBook(command.symbol_)) {
+                market.AddBook(command.symbol_);
+            }
+            auto begin = Clock::now();
+            accepted += market.Apply(command);
+            latency.Record(std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - begin).count());
+        }
+        market.EndBatch();
+    }
+    auto elapsed = std::chrono::duration<double>(Clock::now() - start).count();
+
+    if (options.verbose_) {
+        market.Log();
+    }
+    log::Logger::Instance().Flush();
+#ifdef LATENCY_ENABLE
+    perf::LatencyRegistry::Instance().Dump(std::cout);
+#endif
+
+    std::cout << std::fixed << std::setprecision(1);
+    std::cout << "File:        " << options.file_name_ << " (" << file.Data().size() / 1e6 << " MB)\n";
+    std::cout << "Lines:       " << parser.Lines() << ", invalid " << parser.Errors() << '\n';
+    std::cout << "Commands:    " << latency.Count() << ", accepted " << accepted << '\n';
+    std::cout << "Elapsed:     " << elapsed * 1e3 << " ms\n";
+    std::cout << "Throughput:  " << static_cast<double>(latency.Count()) / elapsed / 1e6 << " M commands/s, "
+              << static_cast<double>(file.Data().size()) / elapsed / 1e6 << " MB/s\n";
+    std::cout << "Latency ns:  p50 " << latency.Percentile(50) << ", p90 " << latency.Percentile(90) << ", p99 "
+              << latency.Percentile(99) << ", p99.9 " << latency.Percentile(99.9) << ", max " << latency.Max()
+              << '\n';
+    return parser.Errors() ? EXIT_FAILURE : EXIT_SUCCESS;
+}
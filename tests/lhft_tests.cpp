@@ -1,9 +1,8 @@
 #define CATCH_CONFIG_RUNNER
 #define CATCH_CONFIG_ENABLE_BENCHMARKING
 #include <catch2/catch.hpp>
-#include <fstream>
 #include <market.hpp>
-#include <ostream>
+#include <order_file.hpp>
 
 std::string filename;
 
@@ -19,73 +18,23 @@ int32_t main(int32_t argc, char* argv[]) {
     return session.run();
 }
 
-struct Order {
-    char                 msg_type_{'\0'};
-    lhft::book::OrderId  order_id_{0};
-    lhft::book::Symbol   symbol_{1};
-    bool                 is_buy_{false};
-    lhft::book::Quantity quantity_{0};
-    lhft::book::Price    price_{0};
-
-    friend std::ostream& operator<<(std::ostream& os, const Order& order) {
-        os << "msg_type: " << order.msg_type_ << " order_id: " << order.order_id_ << " symbol: " << order.symbol_
-           << " is_buy: " << order.is_buy_ << " quantity: " << order.quantity_ << " price: " << order.price_;
-        return os;
-    }
-};
-
-static std::optional<Order> ReadLine(const std::string& line) {
-    std::string        s;
-    std::istringstream iss(line);
-
-    // Reading msg_type
-    std::getline(iss, s, ',');
-    char msg_type = s[0];
-
-    switch (msg_type) {
-        case 'A':
-        case 'X': {
-            Order order;
-            order.msg_type_ = msg_type;
-            std::getline(iss, s, ',');
-            order.order_id_ = std::stoi(s);
-            std::getline(iss, s, ',');
-            order.is_buy_ = s[0] == 'B';
-            std::getline(iss, s, ',');
-            order.quantity_ = std::stoi(s);
-            std::getline(iss, s, ',');
-            order.price_ = std::stoi(s);
-            std::cout << order << '\n';
-            return order;
-        }
-        default: {
-            std::cout << "ERROR: Invalid msg type: " << msg_type << std::endl;
-            return {};
-        }
-    }
-}
-
 TEST_CASE("lhft file test", "[unit]") {
-    std::string   line;
-    std::ifstream infile(filename.c_str(), std::ifstream::in);
-    auto          market = std::make_unique<lhft::me::Market>();
-    REQUIRE(market->AddBook(1));
-    while (std::getline(infile, line)) {
-        auto order = ReadLine(line);
-        if (order) {
-            switch (order->msg_type_) {
-                case 'A':
-                    market->OrderSubmit(std::make_shared<lhft::book::Order>(
-                            order->order_id_, order->is_buy_, order->symbol_, order->quantity_, order->price_));
-                    break;
-                case 'X':
-                    market->OrderCancel(order->order_id_);
-                    break;
-                default:
-                    std::cout << "Invalid msg type " << order->msg_type_ << '\n';
-                    break;
-            }
+    if (filename.empty()) {
+        // Only meaningful with -g
+        return;
+    }
+    lhft::me::MappedFile file;
+    REQUIRE(file.Open(filename));
+    lhft::me::OrderFileParser parser(file.Data());
+    lhft::me::Command         command;
+    auto                      market = std::make_unique<lhft::me::Market>();
+    REQUIRE(market->AddBook(lhft::book::DEFAULT_SYMBOL));
+    while (parser.Next(command)) {
+        if (command.type_ == lhft::me::CommandType::SUBMIT && !market->FindBook(command.symbol_)) {
+            REQUIRE(market->AddBook(command.symbol_));
         }
+        market->Apply(command);
     }
+    REQUIRE(parser.Errors() == 0);
     market->Log();
-}
\ No newline at end of file
+}
@@ -1,7 +1,24 @@
 #define CATCH_CONFIG_ENABLE_BENCHMARKING
 #include <catch2/catch.hpp>
+#include <chrono>
+#include <cstddef>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
 #include <iostream>
+#include <iterator>
+#include <map>
+#include <depth_publisher.hpp>
+#include <engine.hpp>
+#include <journal.hpp>
+#include <latency.hpp>
 #include <market.hpp>
+#include <order_entry.hpp>
+#include <order_file.hpp>
+#include <sharded_market.hpp>
+#include <trade_tape.hpp>
+#include <sstream>
+#include <thread>
 
 TEST_CASE("add market test", "[unit]") {
     auto market = std::make_unique<lhft::me::Market>();
@@ -121,6 +138,129 @@ TEST_CASE("multiple matching order test", "[unit]") {
     market->Log();
 }
 
+TEST_CASE("deferred listener order book test", "[unit]") {
+    using OrderPtr  = std::shared_ptr<lhft::book::Order>;
+    using OrderBook = lhft::book::OrderBook<OrderPtr, lhft::book::DeferredListener<OrderPtr>>;
+    lhft::book::Symbol symbol = 1;
+    OrderBook          book(symbol);
+
+    auto buy  = std::make_shared<lhft::book::Order>(1, true, symbol, 10, 100);
+    auto sell = std::make_shared<lhft::book::Order>(2, false, symbol, 4, 99);
+    REQUIRE_FALSE(book.Add(buy));
+    REQUIRE(buy->QuantityOnMarket() == 10);
+    REQUIRE(book.Add(sell));
+    REQUIRE(sell->QuantityOnMarket() == 0);
+    REQUIRE(buy->QuantityOnMarket() == 6);
+    REQUIRE(buy->FillCost() == 400);
+    REQUIRE(buy->GetTrades().size() == 1);
+    REQUIRE(book.MarketPrice() == 100);
+
+    book.Cancel(buy);
+    REQUIRE(buy->QuantityOnMarket() == 0);
+    REQUIRE(book.GetBids().empty());
+}
+
+TEST_CASE("order lifecycle history test", "[unit]") {
+    lhft::book::Order order(1, true, 1, 100, 10);
+    order.OnSubmitted();
+    std::ostringstream submitted;
+    submitted << *order.CurrentState();
+    REQUIRE(submitted.str() == " Description: BUY 100 1 @10");
+    order.OnAccepted();
+    for (lhft::book::Quantity fill = 1; fill <= 10; ++fill) {
+        order.OnFilled(fill, fill * 10);
+    }
+    REQUIRE(order.QuantityOnMarket() == 45);
+    REQUIRE(order.GetHistory().Size() == lhft::book::ORDER_HISTORY_DEPTH);
+    REQUIRE(order.GetHistory()[0].quantity_ == 10 - lhft::book::ORDER_HISTORY_DEPTH + 1);
+    REQUIRE(order.CurrentState()->state_ == lhft::book::State::FILLED);
+    REQUIRE(order.CurrentState()->quantity_ == 10);
+
+    std::ostringstream out;
+    out << order;
+    REQUIRE(out.str() == "[#1 BUY 1 100 $10 Open: 45 FILLED: 55 Cost: 550 Last Event:  Description: 10 for 100]");
+
+    lhft::book::Order lean(2, false, 1, 5, 10);
+    lean.SetLean(true);
+    lean.OnAccepted();
+    lean.OnFilled(5, 50);
+    lean.AddTradeHistory(5, 0, 50, 1, 10, 1);
+    REQUIRE(lean.GetHistory().Empty());
+    REQUIRE(lean.GetTrades().empty());
+    REQUIRE(lean.CurrentState()->state_ == lhft::book::State::FILLED);
+}
+
+TEST_CASE("pooled market matching test", "[unit]") {
+    auto                market   = std::make_unique<lhft::me::PooledMarket>(lhft::me::PooledOrders(4));
+    lhft::book::Symbol  symbol   = 1;
+    lhft::book::OrderId order_id = 100000;
+    REQUIRE(market->AddBook(symbol));
+    REQUIRE(market->OrderSubmit(market->NewOrder(order_id++, false, symbol, 1, 1075)));
+    REQUIRE(market->OrderSubmit(market->NewOrder(order_id++, true, symbol, 9, 1000)));
+    REQUIRE(market->OrderSubmit(market->NewOrder(order_id++, true, symbol, 30, 975)));
+    REQUIRE(market->OrderSubmit(market->NewOrder(order_id++, false, symbol, 10, 1050)));
+    REQUIRE(market->OrderSubmit(market->NewOrder(order_id++, true, symbol, 10, 950)));
+    REQUIRE(market->OrderSubmit(market->NewOrder(order_id++, false, symbol, 2, 1025)));
+    REQUIRE(market->OrderSubmit(market->NewOrder(order_id++, true, symbol, 1, 1000)));
+    REQUIRE(market->OrderCancel(100004));
+    REQUIRE(market->OrderSubmit(market->NewOrder(order_id++, false, symbol, 5, 1025)));
+    REQUIRE(market->OrderSubmit(market->NewOrder(order_id++, true, symbol, 3, 1050)));
+    REQUIRE_FALSE(market->OrderCancel(100008));
+    REQUIRE(market->OrderSubmit(market->NewOrder(order_id++, true, symbol, 10, 1000)));
+    REQUIRE(market->OrderCancel(100009));
+    REQUIRE_FALSE(market->OrderCancel(100005));
+    REQUIRE_FALSE(market->OrderCancel(100010));
+    REQUIRE(market->OrderSubmit(market->NewOrder(order_id++, false, symbol, 10, 1025)));
+    REQUIRE(market->OrderSubmit(market->NewOrder(order_id++, true, symbol, 10, 1025)));
+    REQUIRE_FALSE(market->OrderSubmit(market->NewOrder(100010, true, symbol, 1, 900)));
+
+    lhft::me::PooledMarket::OrderPtr     order;
+    lhft::me::PooledMarket::OrderBookPtr book;
+    REQUIRE(market->FindExistingOrder(100010, order, book));
+    REQUIRE(order->QuantityOnMarket() == 4);
+    REQUIRE(market->RemoveBook(symbol));
+
+    // Small reserves, one per packet, still grow the pool geometrically
+    lhft::book::ObjectPool<int> pool(4);
+    pool.Reserve(6);
+    REQUIRE(pool.Capacity() == 8);
+    pool.Reserve(9);
+    REQUIRE(pool.Capacity() == 16);
+    pool.Reserve(16);
+    REQUIRE(pool.Capacity() == 16);
+}
+
+TEST_CASE("order index test", "[unit]") {
+    // Small table with a dense window in the middle of the id range, forced to grow and to wrap clusters
+    lhft::me::OrderIndex<lhft::book::OrderId>                    index(8, 1000, 64);
+    std::unordered_map<lhft::book::OrderId, lhft::book::OrderId> expected;
+
+    std::mt19937                                         random_engine(7);
+    std::uniform_int_distribution<lhft::book::OrderId> distribution_id(900, 1200);
+    for (int32_t i = 0; i < 20000; i++) {
+        auto order_id = distribution_id(random_engine);
+        if (i % 3 == 0) {
+            REQUIRE(index.Erase(order_id) == (expected.erase(order_id) == 1));
+        } else {
+            REQUIRE(index.Insert(order_id, order_id * 2) == expected.emplace(order_id, order_id * 2).second);
+        }
+        auto probe = distribution_id(random_engine);
+        auto found = index.Find(probe);
+        REQUIRE((found != nullptr) == (expected.count(probe) == 1));
+        if (found) {
+            REQUIRE(*found == probe * 2);
+        }
+    }
+    REQUIRE(index.Size() == expected.size());
+
+    std::size_t visited = 0;
+    index.ForEach([&](lhft::book::OrderId order_id, lhft::book::OrderId value) {
+        REQUIRE(expected.at(order_id) == value);
+        ++visited;
+    });
+    REQUIRE(visited == expected.size());
+}
+
 TEST_CASE("me benchmark test", "[unit]") {
     auto               market = std::make_unique<lhft::me::Market>();
     lhft::book::Symbol symbol = 1;
@@ -146,6 +286,18 @@ TEST_CASE("me benchmark test", "[unit]") {
         market->RemoveBook(symbol);
     };
 
+    BENCHMARK("benchmark pooled add order") {
+        auto                 market   = std::make_unique<lhft::me::PooledMarket>();
+        lhft::book::Symbol   symbol   = 1;
+        lhft::book::OrderId  order_id = 1;
+        bool                 is_buy   = true;
+        lhft::book::Quantity quantity = 1;
+        lhft::book::Price    price    = 1;
+        market->AddBook(symbol);
+        market->OrderSubmit(market->NewOrder(order_id, is_buy, symbol, quantity, price));
+        market->RemoveBook(symbol);
+    };
+
     BENCHMARK("benchmark fill order book") {
         auto                 market   = std::make_unique<lhft::me::Market>();
         lhft::book::Symbol   symbol   = 1;
@@ -223,4 +375,1441 @@ TEST_CASE("me benchmark test", "[unit]") {
         }
         market->RemoveBook(symbol);
     };
-}
\ No newline at end of file
+
+    BENCHMARK("benchmark sweep with trade tape") {
+        auto                  market   = std::make_unique<lhft::me::PooledMarket>();
+        lhft::book::TradeTape tape(1 << 10);
+        lhft::book::TradeData trades[64];
+        lhft::book::Symbol    symbol   = 1;
+        lhft::book::OrderId   order_id = 1;
+        market->AddBook(symbol);
+        market->SetTradeTape(&tape);
+        for (lhft::book::Price price = 1; price <= 50; ++price) {
+            market->OrderSubmit(market->NewOrder(order_id++, false, symbol, 2, price));
+        }
+        market->OrderSubmit(market->NewOrder(order_id++, true, symbol, 100, 50));
+        return tape.Read(0, trades, 64);
+    };
+}
+TEST_CASE("order replace test", "[unit]") {
+    using OrderPtr  = std::shared_ptr<lhft::book::Order>;
+    using OrderBook = lhft::book::OrderBook<OrderPtr>;
+    lhft::book::Symbol symbol = 1;
+    OrderBook          book(symbol);
+    auto               first  = std::make_shared<lhft::book::Order>(1, false, symbol, 10, 101);
+    auto               second = std::make_shared<lhft::book::Order>(2, false, symbol, 10, 101);
+    REQUIRE_FALSE(book.Add(first));
+    REQUIRE_FALSE(book.Add(second));
+
+    // Size down keeps the place in the queue
+    REQUIRE_FALSE(book.Replace(first, -4));
+    REQUIRE(first->QuantityOnMarket() == 6);
+    REQUIRE(first->OrderQty() == 6);
+    REQUIRE(first->CurrentState()->state_ == lhft::book::State::MODIFIED);
+    REQUIRE(book.GetAsks().begin()->tracker_.Ptr() == first);
+
+    // Size up goes to the back of the queue
+    REQUIRE_FALSE(book.Replace(first, 2));
+    REQUIRE(first->QuantityOnMarket() == 8);
+    REQUIRE(book.GetAsks().begin()->tracker_.Ptr() == second);
+
+    // Rejected without touching the order
+    REQUIRE_FALSE(book.Replace(first, -9));
+    REQUIRE(first->CurrentState()->state_ == lhft::book::State::MODIFY_REJECTED);
+    REQUIRE(first->QuantityOnMarket() == 8);
+
+    // A new price re-queues and can trade on arrival
+    auto bid = std::make_shared<lhft::book::Order>(3, true, symbol, 5, 99);
+    REQUIRE_FALSE(book.Add(bid));
+    REQUIRE(book.Replace(bid, lhft::book::SIZE_UNCHANGED, 101));
+    REQUIRE(bid->QuantityOnMarket() == 0);
+    REQUIRE(second->QuantityOnMarket() == 5);
+    REQUIRE(bid->GetBookHandle() == lhft::book::INVALID_ORDER_HANDLE);
+    REQUIRE_FALSE(book.Replace(bid, -1));
+    REQUIRE(bid->CurrentState()->state_ == lhft::book::State::MODIFY_REJECTED);
+
+    // Through the market, with filled orders retired and commands carrying the new total
+    lhft::me::Market market;
+    market.AddBook(symbol);
+    REQUIRE(market.OrderSubmit(std::make_shared<lhft::book::Order>(10, false, symbol, 10, 105)));
+    REQUIRE(market.OrderSubmit(std::make_shared<lhft::book::Order>(11, true, symbol, 4, 100)));
+    REQUIRE(market.OrderReplace(11, 0, 105));
+    lhft::me::Market::OrderPtr     order;
+    lhft::me::Market::OrderBookPtr found;
+    REQUIRE_FALSE(market.FindExistingOrder(11, order, found));
+    REQUIRE(market.FindExistingOrder(10, order, found));
+    REQUIRE(order->QuantityOnMarket() == 6);
+    REQUIRE_FALSE(market.OrderReplace(10, -7));
+
+    lhft::me::Command command;
+    command.type_     = lhft::me::CommandType::REPLACE;
+    command.order_id_ = 10;
+    command.quantity_ = 7;    // 4 of them already filled
+    REQUIRE(market.Apply(command));
+    REQUIRE(order->QuantityOnMarket() == 3);
+    command.quantity_ = 0;
+    command.price_    = 106;
+    REQUIRE(market.Apply(command));
+    REQUIRE(found->GetAsks().begin()->price_.GetPrice() == 106);
+    command.order_id_ = 12;
+    REQUIRE_FALSE(market.Apply(command));
+}
+
+TEST_CASE("fill driven retirement test", "[unit]") {
+    // Lean orders keep no trade list, the market retires them from what the book reports
+    lhft::me::Market market;
+    market.AddBook(1);
+    auto lean = [](lhft::book::OrderId id, bool buy_side, lhft::book::Quantity quantity, lhft::book::Price price) {
+        auto order = std::make_shared<lhft::book::Order>(id, buy_side, 1, quantity, price);
+        order->SetLean(true);
+        return order;
+    };
+    for (lhft::book::OrderId order_id = 1; order_id <= 500; ++order_id) {
+        REQUIRE(market.OrderSubmit(lean(order_id, false, 2, 100 + order_id % 50)));
+    }
+    auto stop = lean(600, true, 10, 0);
+    stop->SetStopPrice(149);
+    REQUIRE(market.OrderSubmit(stop));
+    REQUIRE(market.OrderSubmit(lean(501, true, 995, 149)));
+
+    // Every order the sweep filled is gone. Trading at 149 released the stop, which took the last 5
+    // and keeps the rest of its quantity open
+    lhft::me::Market::OrderPtr     order;
+    lhft::me::Market::OrderBookPtr book;
+    for (lhft::book::OrderId order_id = 1; order_id <= 501; ++order_id) {
+        REQUIRE_FALSE(market.FindExistingOrder(order_id, order, book));
+    }
+    REQUIRE(market.FindExistingOrder(600, order, book));
+    REQUIRE(order->QuantityOnMarket() == 5);
+    REQUIRE(book->GetAsks().empty());
+
+    // Amended down to nothing, it leaves the market too
+    REQUIRE(market.OrderReplace(600, -5));
+    REQUIRE_FALSE(market.FindExistingOrder(600, order, book));
+}
+
+TEST_CASE("batch submit and cancel test", "[unit]") {
+    using lhft::me::Command;
+    using lhft::me::CommandType;
+    lhft::me::PooledMarket market;
+    market.AddBook(1);
+    market.AddBook(2);
+
+    // Interleaved books, each must still see its own orders in packet order
+    std::vector<Command> packet = {
+            Command{CommandType::SUBMIT, 1, false, 2, 10, 100}, Command{CommandType::SUBMIT, 2, false, 1, 10, 101},
+            Command{CommandType::SUBMIT, 3, true, 2, 4, 100},   Command{CommandType::SUBMIT, 4, true, 1, 5, 99},
+            Command{CommandType::SUBMIT, 5, true, 9, 5, 99},    Command{CommandType::SUBMIT, 2, true, 2, 5, 90},
+            Command{CommandType::SUBMIT, 6, true, 1, 3, 101},
+    };
+    REQUIRE(market.SubmitBatch(packet) == 5);
+    REQUIRE(market.FindBook(1)->AutoFlush());
+
+    lhft::me::PooledMarket::OrderPtr     order;
+    lhft::me::PooledMarket::OrderBookPtr book;
+    REQUIRE(market.FindExistingOrder(1, order, book));
+    REQUIRE(order->QuantityOnMarket() == 6);
+    REQUIRE(market.FindExistingOrder(2, order, book));
+    REQUIRE(order->QuantityOnMarket() == 7);
+    REQUIRE_FALSE(market.FindExistingOrder(3, order, book));
+    REQUIRE_FALSE(market.FindExistingOrder(5, order, book));
+    REQUIRE(market.FindBook(2)->GetBids().empty());
+
+    // Inside an outer batch the books are left for EndBatch to flush
+    market.BeginBatch();
+    std::vector<Command> cancels = {Command{CommandType::CANCEL, 4}, Command{CommandType::CANCEL, 1},
+                                    Command{CommandType::CANCEL, 3}, Command{CommandType::CANCEL, 2}};
+    REQUIRE(market.CancelBatch(cancels) == 3);
+    REQUIRE_FALSE(market.FindBook(1)->AutoFlush());
+    market.EndBatch();
+    REQUIRE(market.FindBook(1)->AutoFlush());
+    REQUIRE(market.FindBook(1)->GetBids().empty());
+    REQUIRE(market.FindBook(1)->GetAsks().empty());
+    REQUIRE(market.FindBook(2)->GetAsks().empty());
+}
+
+TEST_CASE("stop order test", "[unit]") {
+    using OrderPtr  = std::shared_ptr<lhft::book::Order>;
+    using OrderBook = lhft::book::OrderBook<OrderPtr>;
+    lhft::book::Symbol symbol = 1;
+    OrderBook          book(symbol);
+
+    auto stop = [&](lhft::book::OrderId id, bool buy_side, lhft::book::Quantity quantity, lhft::book::Price price,
+                    lhft::book::Price stop_price) {
+        auto order = std::make_shared<lhft::book::Order>(id, buy_side, symbol, quantity, price);
+        order->SetStopPrice(stop_price);
+        return order;
+    };
+    for (lhft::book::Price price : {101, 102, 103, 105}) {
+        REQUIRE_FALSE(book.Add(std::make_shared<lhft::book::Order>(price, false, symbol, 5, price)));
+    }
+
+    // Nothing has traded yet, so every stop waits
+    auto stop_market = stop(10, true, 5, lhft::book::MARKET_ORDER_PRICE, 102);
+    auto stop_limit  = stop(11, true, 5, 104, 103);
+    auto far_stop    = stop(12, true, 5, 0, 110);
+    auto sell_stop   = stop(13, false, 5, 0, 90);
+    for (const auto &order : {stop_limit, far_stop, stop_market, sell_stop}) {
+        REQUIRE_FALSE(book.Add(order));
+    }
+    REQUIRE(book.GetBuyStops().size() == 3);
+    REQUIRE(book.GetBuyStops().begin()->tracker_.Ptr() == stop_market);
+    REQUIRE(book.GetSellStops().size() == 1);
+
+    // A trade at 101 crosses no stop
+    REQUIRE(book.Add(std::make_shared<lhft::book::Order>(20, true, symbol, 5, 101)));
+    REQUIRE(book.GetBuyStops().size() == 3);
+
+    // A trade at 102 releases the stop market order, whose fills at 103 release the stop limit,
+    // which rests what it can't get at 104
+    REQUIRE(book.Add(std::make_shared<lhft::book::Order>(21, true, symbol, 1, 102)));
+    REQUIRE(stop_market->IsTriggered());
+    REQUIRE(stop_market->QuantityOnMarket() == 0);
+    REQUIRE(stop_limit->QuantityOnMarket() == 1);
+    REQUIRE(book.GetBids().begin()->tracker_.Ptr() == stop_limit);
+    REQUIRE(book.GetAsks().begin()->price_.GetPrice() == 105);
+    REQUIRE(book.MarketPrice() == 103);
+    REQUIRE(book.GetBuyStops().size() == 1);
+
+    // Waiting stops cancel from the stop ladder and can't be amended
+    REQUIRE_FALSE(book.Replace(far_stop, -1));
+    REQUIRE(far_stop->CurrentState()->state_ == lhft::book::State::MODIFY_REJECTED);
+    book.Cancel(sell_stop);
+    REQUIRE(sell_stop->CurrentState()->state_ == lhft::book::State::CANCELLED);
+    REQUIRE(book.GetSellStops().empty());
+
+    // A stop already crossed on arrival enters straight away
+    REQUIRE(book.Add(stop(14, true, 2, 0, 100)));
+    REQUIRE(book.GetAsks().begin()->tracker_.OpenQty() == 3);
+
+    // A cascade through a long run of levels, each stop taking the level that releases the next
+    OrderBook cascade(symbol);
+    for (lhft::book::Price price = 200; price < 400; ++price) {
+        REQUIRE_FALSE(cascade.Add(std::make_shared<lhft::book::Order>(price, false, symbol, 1, price)));
+        REQUIRE_FALSE(cascade.Add(stop(1000 + price, true, 1, 0, price)));
+    }
+    REQUIRE(cascade.Add(std::make_shared<lhft::book::Order>(1, true, symbol, 1, 200)));
+    REQUIRE(cascade.GetAsks().empty());
+    REQUIRE(cascade.GetBuyStops().empty());
+    REQUIRE(cascade.GetBids().size() == 1);    // the last stop finds nothing left to buy
+    REQUIRE(cascade.MarketPrice() == 399);
+}
+
+TEST_CASE("level aggregate test", "[unit]") {
+    using OrderPtr  = std::shared_ptr<lhft::book::Order>;
+    using OrderBook = lhft::book::OrderBook<OrderPtr>;
+    OrderBook             book(1, 64);    // narrow window, so levels also live in the overflow
+    std::vector<OrderPtr> orders;
+    std::mt19937          random_engine(11);
+
+    // Random adds, crossing orders, cancels and amends, checked against a sum over every order
+    for (lhft::book::OrderId order_id = 1; order_id <= 3000; ++order_id) {
+        auto roll = random_engine() % 10;
+        if (roll < 6 || orders.empty()) {
+            bool              buy_side = random_engine() % 2 == 0;
+            lhft::book::Price price    = buy_side ? 900 + random_engine() % 120 : 1000 + random_engine() % 120;
+            if (roll == 0) {
+                price = buy_side ? price + 40 : price - 40;    // crosses now and then
+            }
+            orders.push_back(std::make_shared<lhft::book::Order>(order_id, buy_side, 1, 1 + random_engine() % 9,
+                                                                 price));
+            (void)book.Add(orders.back());
+        } else {
+            auto &order = orders[random_engine() % orders.size()];
+            if (roll < 8) {
+                book.Cancel(order);
+            } else {
+                (void)book.Replace(order, -static_cast<int64_t>(random_engine() % 3));
+            }
+        }
+    }
+
+    for (bool buy_side : {true, false}) {
+        const auto &side = buy_side ? book.GetBids() : book.GetAsks();
+        std::map<lhft::book::Price, std::pair<lhft::book::Quantity, uint32_t>> expected;
+        for (const auto &entry : side) {
+            auto &level = expected[entry.price_.GetPrice()];
+            level.first += entry.tracker_.OpenQty();
+            ++level.second;
+        }
+        for (const auto &[price, level] : expected) {
+            REQUIRE(book.LevelQuantity(buy_side, price) == level.first);
+            REQUIRE(book.LevelOrders(buy_side, price) == level.second);
+        }
+
+        lhft::book::LevelView top[8];
+        auto                  depth = book.TopLevels(buy_side, 8, top);
+        REQUIRE(depth == (std::min)(expected.size(), std::size_t{8}));
+        REQUIRE(top[0].price_ == (buy_side ? book.BestBid() : book.BestAsk()));
+        for (std::size_t index = 0; index < depth; ++index) {
+            auto level = buy_side ? std::prev(expected.end(), index + 1) : std::next(expected.begin(), index);
+            REQUIRE(top[index].price_ == level->first);
+            REQUIRE(top[index].quantity_ == level->second.first);
+            REQUIRE(top[index].orders_ == level->second.second);
+        }
+    }
+    REQUIRE(book.LevelQuantity(true, 5000) == 0);
+
+    OrderBook empty(1);
+    REQUIRE(empty.BestBid() == lhft::book::INVALID_LEVEL_PRICE);
+    REQUIRE(empty.TopLevels(false, 8, nullptr) == 0);
+}
+
+TEST_CASE("time in force test", "[unit]") {
+    using lhft::book::State;
+    using lhft::book::TimeInForce;
+    lhft::me::Market market;
+    market.AddBook(1);
+    REQUIRE(market.OrderSubmit(market.NewOrder(1, false, 1, 5, 100)));
+    REQUIRE(market.OrderSubmit(market.NewOrder(2, false, 1, 5, 101)));
+
+    lhft::me::Market::OrderPtr     order;
+    lhft::me::Market::OrderBookPtr book;
+    REQUIRE(market.FindExistingOrder(1, order, book));
+
+    // IOC takes what is there and the rest is cancelled, never resting
+    auto ioc = market.NewOrder(3, true, 1, 8, 100);
+    ioc->SetTimeInForce(TimeInForce::IOC);
+    REQUIRE(market.OrderSubmit(ioc));
+    REQUIRE(ioc->QuantityFilled() == 5);
+    REQUIRE(ioc->CurrentState()->state_ == State::CANCELLED);
+    REQUIRE(book->GetBids().empty());
+    REQUIRE_FALSE(market.FindExistingOrder(3, order, book));
+
+    // FOK that can't fill completely leaves the book untouched
+    auto fok = market.NewOrder(4, true, 1, 6, 101);
+    fok->SetTimeInForce(TimeInForce::FOK);
+    REQUIRE(market.OrderSubmit(fok));
+    REQUIRE(fok->CurrentState()->state_ == State::REJECTED);
+    REQUIRE(book->LevelQuantity(false, 101) == 5);
+    REQUIRE_FALSE(market.FindExistingOrder(4, order, book));
+
+    REQUIRE(market.OrderSubmit(market.NewOrder(5, false, 1, 3, 102)));
+    auto filled = market.NewOrder(6, true, 1, 8, 102);
+    filled->SetTimeInForce(TimeInForce::FOK);
+    REQUIRE(market.OrderSubmit(filled));
+    REQUIRE(filled->QuantityFilled() == 8);
+    REQUIRE(book->GetAsks().empty());
+
+    // Post only rests when it would not trade and is rejected when it would
+    REQUIRE(market.OrderSubmit(market.NewOrder(7, false, 1, 5, 105)));
+    auto maker = market.NewOrder(8, true, 1, 5, 104);
+    maker->SetPostOnly(true);
+    REQUIRE(market.OrderSubmit(maker));
+    REQUIRE(book->LevelQuantity(true, 104) == 5);
+    auto taker = market.NewOrder(9, true, 1, 5, 105);
+    taker->SetPostOnly(true);
+    REQUIRE(market.OrderSubmit(taker));
+    REQUIRE(taker->CurrentState()->state_ == State::REJECTED);
+    REQUIRE(book->LevelQuantity(false, 105) == 5);
+
+    // And stays passive through a replace
+    REQUIRE_FALSE(market.OrderReplace(8, 0, 105));
+    REQUIRE(book->LevelQuantity(true, 104) == 5);
+    REQUIRE(market.OrderReplace(8, 0, 103));
+    REQUIRE(book->LevelQuantity(true, 103) == 5);
+}
+
+TEST_CASE("call auction test", "[unit]") {
+    using lhft::book::State;
+    lhft::me::Market market;
+    market.AddBook(1);
+    REQUIRE(market.AuctionBegin(1));
+
+    // Collected without trading although the book is crossed
+    REQUIRE(market.OrderSubmit(market.NewOrder(1, false, 1, 5, 100)));
+    REQUIRE(market.OrderSubmit(market.NewOrder(2, false, 1, 5, 101)));
+    REQUIRE(market.OrderSubmit(market.NewOrder(3, false, 1, 10, 103)));
+    REQUIRE(market.OrderSubmit(market.NewOrder(4, true, 1, 4, 103)));
+    REQUIRE(market.OrderSubmit(market.NewOrder(5, true, 1, 6, 102)));
+    REQUIRE(market.OrderSubmit(market.NewOrder(6, true, 1, 5, 100)));
+    REQUIRE(market.OrderSubmit(market.NewOrder(7, true, 1, 2, lhft::book::MARKET_ORDER_PRICE)));
+    auto ioc = market.NewOrder(8, true, 1, 1, 103);
+    ioc->SetTimeInForce(lhft::book::TimeInForce::IOC);
+    REQUIRE(market.OrderSubmit(ioc));
+    REQUIRE(ioc->CurrentState()->state_ == State::REJECTED);
+
+    lhft::me::Market::OrderPtr     order;
+    lhft::me::Market::OrderBookPtr book;
+    REQUIRE(market.FindExistingOrder(4, order, book));
+    REQUIRE(book->InAuction());
+    REQUIRE(book->GetBids().size() == 4);
+    REQUIRE(book->GetAsks().size() == 3);
+
+    // 101 and 102 both execute 10 with an imbalance of 2, with no last trade the lower one wins
+    REQUIRE(market.AuctionUncross(1) == 101);
+    REQUIRE_FALSE(book->InAuction());
+    REQUIRE(book->MarketPrice() == 101);
+    REQUIRE(order->FillCost() == 4 * 101);
+    for (lhft::book::OrderId order_id : {1, 2, 4, 7}) {
+        REQUIRE_FALSE(market.FindExistingOrder(order_id, order, book));
+    }
+    REQUIRE(book->LevelQuantity(true, 102) == 2);
+    REQUIRE(book->LevelQuantity(true, 100) == 5);
+    REQUIRE(book->LevelQuantity(false, 103) == 10);
+    REQUIRE(book->BestAsk() == 103);
+
+    // Continuous matching is back, and a book that doesn't cross uncrosses to nothing
+    auto seller = market.NewOrder(9, false, 1, 2, 102);
+    REQUIRE(market.OrderSubmit(seller));
+    REQUIRE(seller->QuantityFilled() == 2);
+    REQUIRE(market.AuctionBegin(1));
+    REQUIRE(market.AuctionUncross(1) == lhft::book::INVALID_LEVEL_PRICE);
+}
+
+TEST_CASE("mass cancel test", "[unit]") {
+    using lhft::book::MassCancelFilter;
+    using lhft::book::State;
+    lhft::me::Market market;
+    market.AddBook(1);
+    market.AddBook(2);
+    std::vector<lhft::me::Market::OrderPtr> orders;
+    for (lhft::book::OrderId order_id = 1; order_id <= 40; ++order_id) {
+        bool buy_side = order_id % 2 == 0;
+        auto order    = market.NewOrder(order_id, buy_side, 1 + order_id % 4 / 2, 10, buy_side ? 100 - order_id % 5
+                                                                                          : 110 + order_id % 5);
+        order->SetOwner(1 + order_id % 3);
+        REQUIRE(market.OrderSubmit(order));
+        orders.push_back(order);
+    }
+    auto stop = market.NewOrder(41, true, 1, 10, 0, 120);
+    stop->SetOwner(1);
+    REQUIRE(market.OrderSubmit(stop));
+
+    // One side of one book, its waiting stops included
+    lhft::me::Market::OrderPtr     order;
+    lhft::me::Market::OrderBookPtr book;
+    REQUIRE(market.FindExistingOrder(4, order, book));
+    auto asks = book->GetAsks().size();
+    REQUIRE(market.OrderMassCancel(1, MassCancelFilter{true, false}) == 11);
+    REQUIRE(book->GetBids().empty());
+    REQUIRE(book->GetBuyStops().empty());
+    REQUIRE(book->GetAsks().size() == asks);
+    REQUIRE(stop->CurrentState()->state_ == State::CANCELLED);
+    REQUIRE_FALSE(market.FindExistingOrder(41, order, book));
+
+    // One owner across books, the other orders keep their levels and totals
+    REQUIRE(market.OwnerMassCancel(2) == 10);
+    std::size_t resting = 0;
+    for (const auto &entry : orders) {
+        bool gone = entry->GetOwner() == 2 || (entry->IsBuy() && entry->GetSymbol() == 1);
+        REQUIRE(market.FindExistingOrder(entry->GetOrderId(), order, book) != gone);
+        resting += gone ? 0 : 1;
+    }
+    REQUIRE(resting == 20);
+    REQUIRE(market.FindExistingOrder(5, order, book));
+    REQUIRE(book->LevelQuantity(false, 111) == 10 * book->LevelOrders(false, 111));
+
+    // A book cleared as a whole takes new orders as before
+    REQUIRE(market.OrderMassCancel(1) != 0);
+    REQUIRE(book->GetAsks().empty());
+    REQUIRE(market.OrderSubmit(market.NewOrder(50, false, 1, 5, 105)));
+    auto buyer = market.NewOrder(51, true, 1, 5, 105);
+    REQUIRE(market.OrderSubmit(buyer));
+    REQUIRE(buyer->QuantityFilled() == 5);
+
+    REQUIRE(market.RemoveBook(2));
+    for (const auto &entry : orders) {
+        REQUIRE_FALSE(market.FindExistingOrder(entry->GetOrderId(), order, book));
+    }
+}
+
+TEST_CASE("mass cancel command test", "[unit]") {
+    using lhft::me::Command;
+    using lhft::me::CommandType;
+    using lhft::me::Side;
+    auto file_name = (std::filesystem::temp_directory_path() / "lhft_mass_cancel_journal.bin").string();
+    std::filesystem::remove(file_name);
+
+    // Owners 1 and 2 on both sides, then the sells of owner 2 are cancelled by a wire message
+    std::vector<Command> commands{{CommandType::ADD_BOOK, 0, false, 1, 0, 0}};
+    for (lhft::book::OrderId order_id = 1; order_id <= 8; ++order_id) {
+        Command submit{CommandType::SUBMIT, order_id, order_id % 2 == 0, 1, 5, order_id % 2 == 0 ? 90U : 110U};
+        submit.owner_ = 1 + order_id % 4 / 2;
+        commands.push_back(submit);
+    }
+    lhft::me::MessageEncoder encoder;
+    encoder.MassCancel(1, Side::SELL, 2);
+    lhft::me::MessageDecoder decoder;
+    REQUIRE(decoder.Decode(encoder.Data(), encoder.Size(),
+                           [&](const Command &command) { commands.push_back(command); }) == encoder.Size());
+    REQUIRE(commands.back().type_ == CommandType::MASS_CANCEL);
+    auto cancelled = [](lhft::book::OrderId order_id) { return order_id == 3 || order_id == 7; };
+
+    // Through the engine and its journal
+    {
+        lhft::me::CommandJournal journal(4);
+        REQUIRE(journal.Open(file_name, 8));
+        lhft::me::PooledEngine engine(64, 8);
+        engine.SetJournal(&journal);
+        for (const auto &command : commands) {
+            REQUIRE(engine.Submit(command));
+        }
+        while (engine.Poll()) {
+        }
+        REQUIRE(engine.Processed() == commands.size());
+        lhft::me::PooledEngine::Market::OrderPtr     order;
+        lhft::me::PooledEngine::Market::OrderBookPtr book;
+        for (lhft::book::OrderId order_id = 1; order_id <= 8; ++order_id) {
+            REQUIRE(engine.GetMarket().FindExistingOrder(order_id, order, book) != cancelled(order_id));
+        }
+        REQUIRE(engine.GetMarket().FindExistingOrder(2, order, book));
+        REQUIRE(order->GetOwner() == 2);
+    }
+
+    // Replaying the journal cancels the same orders
+    lhft::me::JournalReader reader;
+    REQUIRE(reader.Open(file_name));
+    REQUIRE(reader.At(reader.Size() - 1).command_.owner_ == 2);
+    lhft::me::PooledMarket replayed;
+    REQUIRE(lhft::me::Replay(reader, replayed, 4) == commands.size());
+    lhft::me::PooledMarket::OrderPtr     order;
+    lhft::me::PooledMarket::OrderBookPtr book;
+    for (lhft::book::OrderId order_id = 1; order_id <= 8; ++order_id) {
+        REQUIRE(replayed.FindExistingOrder(order_id, order, book) != cancelled(order_id));
+    }
+    reader.Close();
+    std::filesystem::remove(file_name);
+
+    // And through the shards, this time the bids of owner 1
+    lhft::me::PooledShardedMarket sharded(2);
+    sharded.AddBook(1);
+    for (lhft::book::OrderId order_id = 1; order_id <= 8; ++order_id) {
+        sharded.OrderSubmit(order_id, order_id % 2 == 0, 1, 5, order_id % 2 == 0 ? 90 : 110, 1 + order_id % 4 / 2);
+    }
+    sharded.OrderMassCancel(1, lhft::book::MassCancelFilter{true, false, 1});
+    for (lhft::book::OrderId order_id = 1; order_id <= 8; ++order_id) {
+        sharded.OrderCancel(1, order_id);
+    }
+    sharded.Wait();
+    lhft::me::PooledShardedMarket::Reports reports;
+    REQUIRE(sharded.Poll(reports) == 18);
+    REQUIRE(reports[9].command_.type_ == CommandType::MASS_CANCEL);
+    REQUIRE(reports[9].result_);
+    for (lhft::book::OrderId order_id = 1; order_id <= 8; ++order_id) {
+        REQUIRE(reports[9 + order_id].result_ != (order_id == 4 || order_id == 8));
+    }
+}
+
+TEST_CASE("price ladder order book test", "[unit]") {
+    using OrderPtr  = std::shared_ptr<lhft::book::Order>;
+    using OrderBook = lhft::book::OrderBook<OrderPtr>;
+    lhft::book::Symbol symbol = 1;
+    OrderBook          book(symbol, 64);
+
+    // 5000 moves the anchor away from 100, so 100 and 90 end up outside the dense window
+    REQUIRE_FALSE(book.Add(std::make_shared<lhft::book::Order>(1, true, symbol, 1, 100)));
+    REQUIRE_FALSE(book.Add(std::make_shared<lhft::book::Order>(2, true, symbol, 2, 5000)));
+    REQUIRE_FALSE(book.Add(std::make_shared<lhft::book::Order>(3, true, symbol, 3, 90)));
+    REQUIRE_FALSE(book.Add(std::make_shared<lhft::book::Order>(4, true, symbol, 4, 5000)));
+    REQUIRE_FALSE(book.Add(std::make_shared<lhft::book::Order>(5, false, symbol, 5, 6000)));
+    REQUIRE_FALSE(book.Add(std::make_shared<lhft::book::Order>(6, false, symbol, 6, 5500)));
+
+    std::vector<lhft::book::OrderId> bids;
+    for (const auto& entry : book.GetBids()) {
+        bids.push_back(entry.tracker_.Ptr()->GetOrderId());
+    }
+    REQUIRE(bids == std::vector<lhft::book::OrderId>{2, 4, 1, 3});
+
+    std::vector<lhft::book::OrderId> asks;
+    for (auto ask = book.GetAsks().rbegin(); ask != book.GetAsks().rend(); ++ask) {
+        asks.push_back(ask->tracker_.Ptr()->GetOrderId());
+    }
+    REQUIRE(asks == std::vector<lhft::book::OrderId>{5, 6});
+
+    // Sweep through both the window and the overflow levels
+    REQUIRE(book.Add(std::make_shared<lhft::book::Order>(7, false, symbol, 8, 90)));
+    REQUIRE(book.GetBids().size() == 1);
+    REQUIRE(book.GetBids().BestPrice() == 90);
+    REQUIRE(book.GetBids().begin()->tracker_.OpenQty() == 2);
+    REQUIRE(book.MarketPrice() == 90);
+
+    OrderPtr resting = book.GetBids().begin()->tracker_.Ptr();
+    book.Cancel(resting);
+    REQUIRE(resting->QuantityOnMarket() == 0);
+    REQUIRE(book.GetBids().empty());
+    REQUIRE(book.GetAsks().BestPrice() == 5500);
+}
+
+TEST_CASE("cancel from deep level test", "[unit]") {
+    using OrderPtr  = std::shared_ptr<lhft::book::Order>;
+    using OrderBook = lhft::book::OrderBook<OrderPtr>;
+    lhft::book::Symbol    symbol = 1;
+    OrderBook             book(symbol);
+    std::vector<OrderPtr> orders;
+    for (lhft::book::OrderId order_id = 1; order_id <= 1000; ++order_id) {
+        orders.push_back(std::make_shared<lhft::book::Order>(order_id, false, symbol, 1, 1000));
+        REQUIRE_FALSE(book.Add(orders.back()));
+        REQUIRE(orders.back()->GetBookHandle() != lhft::book::INVALID_ORDER_HANDLE);
+    }
+
+    book.Cancel(orders[500]);
+    REQUIRE(orders[500]->GetBookHandle() == lhft::book::INVALID_ORDER_HANDLE);
+    REQUIRE(orders[500]->QuantityOnMarket() == 0);
+    REQUIRE(book.GetAsks().size() == 999);
+
+    // A second cancel of the same order is rejected rather than searched for
+    book.Cancel(orders[500]);
+    REQUIRE(book.GetAsks().size() == 999);
+
+    // Time priority is kept around the hole
+    REQUIRE(book.Add(std::make_shared<lhft::book::Order>(1001, true, symbol, 501, 1000)));
+    REQUIRE(orders[499]->GetBookHandle() == lhft::book::INVALID_ORDER_HANDLE);
+    REQUIRE(book.GetAsks().begin()->tracker_.Ptr() == orders[502]);
+}
+
+TEST_CASE("async logger test", "[unit]") {
+    auto &logger    = lhft::log::Logger::Instance();
+    auto  file_name = std::filesystem::temp_directory_path() / "lhft_logger_test.log";
+    REQUIRE(logger.Open(file_name.string()));
+    auto dropped = logger.Dropped();
+
+    lhft::book::Order order(7, true, 1, 10, 1000);
+    order.OnAccepted();
+    std::string reason = "not found";
+    logger.Write(lhft::log::Level::INFO, "Order {} qty {} {}", lhft::book::OrderSnapshot(order), 10, reason);
+    logger.Write(lhft::log::Level::ERROR, "no arguments");
+    std::thread([&logger] { logger.Write(lhft::log::Level::INFO, "from {}", "worker"); }).join();
+
+    logger.SetLevel(lhft::log::Level::ERROR);
+    REQUIRE_FALSE(logger.Enabled(lhft::log::Level::INFO));
+    REQUIRE(logger.Enabled(lhft::log::Level::ERROR));
+    logger.SetLevel(lhft::log::Level::INFO);
+    logger.Flush();
+
+    std::ifstream            log_file(file_name);
+    std::vector<std::string> lines;
+    for (std::string line; std::getline(log_file, line);) {
+        lines.push_back(line);
+    }
+    std::stringstream order_text;
+    order_text << order;
+    REQUIRE(lines.size() == 3);
+    REQUIRE(lines[0] == "INFO: Order " + order_text.str() + " qty 10 not found");
+    REQUIRE(lines[1] == "ERROR: no arguments");
+    REQUIRE(lines[2] == "INFO: from worker");
+    REQUIRE(logger.Dropped() == dropped);
+
+    // Rings of exited threads are released once drained
+    auto rings = logger.Rings();
+    for (int thread = 0; thread < 8; ++thread) {
+        std::thread([&logger] { logger.Write(lhft::log::Level::INFO, "from {}", "worker"); }).join();
+    }
+    for (int wait = 0; wait < 1000 && logger.Rings() > rings; ++wait) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    REQUIRE(logger.Rings() <= rings);
+    logger.Flush();
+
+    // An empty name goes back to standard output
+    REQUIRE_FALSE(logger.Open(""));
+    std::filesystem::remove(file_name);
+}
+
+TEST_CASE("sharded market test", "[unit]") {
+    lhft::me::PooledShardedMarket market(4);
+    REQUIRE(market.Shards() == 4);
+    for (lhft::book::Symbol symbol = 1; symbol <= 8; ++symbol) {
+        market.AddBook(symbol);
+    }
+    for (lhft::book::Symbol symbol = 1; symbol <= 8; ++symbol) {
+        lhft::book::OrderId base = symbol * 100;
+        market.OrderSubmit(base + 1, false, symbol, 10, 1000);
+        market.OrderSubmit(base + 2, true, symbol, 4, 1000);
+        market.OrderSubmit(base + 1, true, symbol, 4, 1000);
+        market.OrderCancel(symbol, base + 1);
+        market.OrderCancel(symbol, base + 1);
+    }
+    market.Wait();
+
+    lhft::me::PooledShardedMarket::Reports reports;
+    REQUIRE(market.Poll(reports) == 56);
+    REQUIRE(market.Poll(reports) == 0);
+
+    std::vector<std::vector<lhft::me::ShardReport>> by_symbol(9);
+    for (std::size_t index = 0; index < reports.size(); ++index) {
+        const auto &report = reports[index];
+        REQUIRE(report.stream_header_.seq_no_ == index + 1);
+        REQUIRE(report.shard_ == market.ShardOf(report.command_.symbol_));
+        if (report.stream_header_.message_type_ == lhft::book::TRADE_EVENT_TICK) {
+            // The trade follows the report of the order that took liquidity
+            lhft::book::OrderId base = report.command_.symbol_ * 100;
+            REQUIRE(reports[index - 1].command_.order_id_ == base + 2);
+            REQUIRE(report.trade_.buyer_id_ == base + 2);
+            REQUIRE(report.trade_.seller_id_ == base + 1);
+            REQUIRE(report.trade_.quantity_ == 4);
+            continue;
+        }
+        by_symbol[report.command_.symbol_].push_back(report);
+    }
+    for (lhft::book::Symbol symbol = 1; symbol <= 8; ++symbol) {
+        // Commands of one symbol are reported in the order they were routed
+        const auto &events = by_symbol[symbol];
+        REQUIRE(events.size() == 6);
+        REQUIRE(events[0].command_.type_ == lhft::me::CommandType::ADD_BOOK);
+        REQUIRE(events[0].result_);
+        REQUIRE(events[1].result_);
+        REQUIRE(events[2].result_);
+        REQUIRE_FALSE(events[3].result_);
+        REQUIRE(events[4].result_);
+        REQUIRE_FALSE(events[5].result_);
+    }
+
+    // Workers idle long enough to park are woken by the next command
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    market.AddBook(9);
+    market.Wait();
+    REQUIRE(market.Poll(reports) == 1);
+    REQUIRE(reports.back().result_);
+    REQUIRE(reports.back().stream_header_.seq_no_ == 57);
+}
+
+TEST_CASE("spsc ring test", "[unit]") {
+    lhft::me::SpscRing<int> ring(6);
+    REQUIRE(ring.Capacity() == 8);
+    int value = 0;
+    REQUIRE_FALSE(ring.TryPop(value));
+    for (int round = 0; round < 3; ++round) {
+        for (int index = 0; index < 8; ++index) {
+            REQUIRE(ring.TryPush(round * 8 + index));
+        }
+        REQUIRE_FALSE(ring.TryPush(-1));
+        REQUIRE(ring.Size() == 8);
+
+        REQUIRE(ring.TryPop(value));
+        REQUIRE(value == round * 8);
+        int batch[8];
+        REQUIRE(ring.PopBatch(batch, 5) == 5);
+        REQUIRE(batch[4] == round * 8 + 5);
+        REQUIRE(ring.PopBatch(batch, 8) == 2);
+        REQUIRE(batch[1] == round * 8 + 7);
+        REQUIRE(ring.Empty());
+    }
+
+    lhft::me::SpscRing<std::size_t> shared(64);
+    constexpr std::size_t           count = 100000;
+    std::thread                     producer([&shared] {
+        for (std::size_t index = 0; index < count;) {
+            if (shared.TryPush(index)) {
+                ++index;
+            }
+        }
+    });
+    std::size_t expected = 0;
+    std::size_t received[16];
+    while (expected < count) {
+        std::size_t popped = shared.PopBatch(received, 16);
+        for (std::size_t index = 0; index < popped; ++index) {
+            REQUIRE(received[index] == expected++);
+        }
+    }
+    producer.join();
+}
+
+TEST_CASE("engine command ring test", "[unit]") {
+    using lhft::me::Command;
+    using lhft::me::CommandType;
+    lhft::me::PooledEngine engine(16, 4);
+    engine.Start();
+
+    // More commands than the ring holds, the gateway retries instead of blocking
+    std::vector<Command> commands{{CommandType::ADD_BOOK, 0, false, 1, 0, 0}, {CommandType::ADD_BOOK, 0, false, 2, 0, 0}};
+    for (lhft::book::OrderId order_id = 1; order_id <= 40; ++order_id) {
+        commands.push_back({CommandType::SUBMIT, order_id, false, 1 + order_id % 2, 10, 1000 + order_id});
+    }
+    commands.push_back({CommandType::SUBMIT, 41, true, 1, 25, 1100});
+    commands.push_back({CommandType::CANCEL, 3, false, 2, 0, 0});
+    commands.push_back({CommandType::MASS_CANCEL, 0, false, 2, 0, 0});
+    commands.push_back({CommandType::SUBMIT, 42, true, 2, 10, 2000});
+
+    std::thread gateway([&engine, &commands] {
+        for (const auto &command : commands) {
+            while (!engine.Submit(command)) {
+            }
+        }
+    });
+    gateway.join();
+    while (engine.Processed() != commands.size()) {
+        std::this_thread::yield();
+    }
+    engine.Stop();
+
+    auto &market = engine.GetMarket();
+    lhft::me::PooledEngine::Market::OrderPtr     order;
+    lhft::me::PooledEngine::Market::OrderBookPtr book;
+    // Buy 41 took #2 and #4 and 5 of #6 on symbol 1 and rests nothing
+    REQUIRE_FALSE(market.FindExistingOrder(2, order, book));
+    REQUIRE_FALSE(market.FindExistingOrder(41, order, book));
+    REQUIRE(market.FindExistingOrder(6, order, book));
+    REQUIRE(order->QuantityOnMarket() == 5);
+    REQUIRE(book->GetAsks().size() == 18);
+    // Symbol 2 was mass cancelled before #42 arrived
+    REQUIRE_FALSE(market.FindExistingOrder(5, order, book));
+    REQUIRE(market.FindExistingOrder(42, order, book));
+    REQUIRE(order->QuantityOnMarket() == 10);
+    REQUIRE(book->GetAsks().empty());
+}
+
+TEST_CASE("incremental depth publisher test", "[unit]") {
+    using OrderPtr  = std::shared_ptr<lhft::book::Order>;
+    using Listener  = lhft::book::DepthListener<OrderPtr>;
+    using OrderBook = lhft::book::OrderBook<OrderPtr, Listener>;
+    lhft::book::Symbol symbol = 3;
+    OrderBook          book(symbol);
+    auto &             publisher = book.GetListener().GetPublisher();
+
+    REQUIRE_FALSE(book.Add(std::make_shared<lhft::book::Order>(1, false, symbol, 10, 1010)));
+    REQUIRE_FALSE(book.Add(std::make_shared<lhft::book::Order>(2, false, symbol, 5, 1010)));
+    REQUIRE_FALSE(book.Add(std::make_shared<lhft::book::Order>(3, false, symbol, 7, 1020)));
+    auto bid = std::make_shared<lhft::book::Order>(4, true, symbol, 8, 1000);
+    REQUIRE_FALSE(book.Add(bid));
+
+    const auto &changes = publisher.GetChanges();
+    REQUIRE(changes.size() == 4);
+    REQUIRE(changes[1].stream_header_.seq_no_ == 2);
+    REQUIRE(changes[1].stream_header_.message_type_ == lhft::book::BOOK_CHANGE);
+    REQUIRE(changes[1].symbol_ == symbol);
+    REQUIRE_FALSE(changes[1].buy_side_);
+    REQUIRE(changes[1].price_ == 1010);
+    REQUIRE(changes[1].quantity_ == 15);
+    REQUIRE(changes[3].buy_side_);
+    REQUIRE(changes[3].quantity_ == 8);
+    publisher.ClearChanges();
+
+    // A sweep only reports the levels it hit plus the level the remainder rests on
+    REQUIRE(book.Add(std::make_shared<lhft::book::Order>(5, true, symbol, 25, 1020)));
+    REQUIRE(changes.size() == 3);
+    REQUIRE(changes[0].price_ == 1010);
+    REQUIRE(changes[0].quantity_ == 0);
+    REQUIRE_FALSE(changes[1].buy_side_);
+    REQUIRE(changes[1].price_ == 1020);
+    REQUIRE(changes[1].quantity_ == 0);
+    REQUIRE(changes[2].buy_side_);
+    REQUIRE(changes[2].price_ == 1020);
+    REQUIRE(changes[2].quantity_ == 3);
+    publisher.ClearChanges();
+
+    book.Cancel(bid);
+    REQUIRE(changes.size() == 1);
+    REQUIRE(changes[0].buy_side_);
+    REQUIRE(changes[0].price_ == 1000);
+    REQUIRE(changes[0].quantity_ == 0);
+
+    auto snapshot = publisher.TakeSnapshot(book);
+    REQUIRE(snapshot.stream_header_.seq_no_ == changes[0].stream_header_.seq_no_ + 1);
+    REQUIRE(snapshot.stream_header_.message_type_ == lhft::book::BOOK_UPDATE);
+    REQUIRE(snapshot.bids_[0] == std::make_pair<lhft::book::Price, lhft::book::Quantity>(1020, 3));
+    REQUIRE(snapshot.bids_[1].second == 0);
+    REQUIRE(snapshot.asks_[0].second == 0);
+
+    // A level emptied by a fill and added to again in one batch yields exactly one change
+    publisher.ClearChanges();
+    book.SetAutoFlush(false);
+    REQUIRE(book.Add(std::make_shared<lhft::book::Order>(6, false, symbol, 5, 1010)));
+    REQUIRE(book.Add(std::make_shared<lhft::book::Order>(7, true, symbol, 4, 1020)));
+    REQUIRE(changes.empty());
+    book.CallbackNow();
+    REQUIRE(changes.size() == 2);
+    REQUIRE_FALSE(changes[0].buy_side_);
+    REQUIRE(changes[0].price_ == 1010);
+    REQUIRE(changes[0].quantity_ == 0);
+    REQUIRE(changes[1].buy_side_);
+    REQUIRE(changes[1].price_ == 1020);
+    REQUIRE(changes[1].quantity_ == 2);
+}
+
+TEST_CASE("deferred depth publisher test", "[unit]") {
+    using OrderPtr  = std::shared_ptr<lhft::book::Order>;
+    using Listener  = lhft::book::DeferredListener<OrderPtr, lhft::book::DepthListener<OrderPtr>>;
+    using OrderBook = lhft::book::OrderBook<OrderPtr, Listener>;
+    using Level     = std::pair<bool, lhft::book::Price>;
+    lhft::book::Symbol symbol = 3;
+    OrderBook          book(symbol);
+    auto &             publisher = book.GetListener().GetHandler().GetPublisher();
+    book.SetAutoFlush(false);
+
+    // The updates are only handled at the flush, they still carry the levels of every operation
+    auto first = std::make_shared<lhft::book::Order>(1, false, symbol, 10, 1010);
+    REQUIRE_FALSE(book.Add(first));
+    REQUIRE_FALSE(book.Add(std::make_shared<lhft::book::Order>(2, false, symbol, 5, 1020)));
+    book.Cancel(first);
+    REQUIRE_FALSE(book.Add(std::make_shared<lhft::book::Order>(3, true, symbol, 8, 1000)));
+    REQUIRE(publisher.GetChanges().empty());
+    book.CallbackNow();
+
+    std::map<Level, lhft::book::Quantity> depth;
+    for (const auto &change : publisher.GetChanges()) {
+        depth[Level{change.buy_side_, change.price_}] = change.quantity_;
+    }
+    REQUIRE(depth.size() == 3);
+    REQUIRE(depth[Level{false, 1010}] == 0);
+    REQUIRE(depth[Level{false, 1020}] == 5);
+    REQUIRE(depth[Level{true, 1000}] == 8);
+    publisher.ClearChanges();
+
+    // The next batch starts over
+    REQUIRE_FALSE(book.Add(std::make_shared<lhft::book::Order>(4, false, symbol, 3, 1020)));
+    book.CallbackNow();
+    REQUIRE(publisher.GetChanges().size() == 1);
+    REQUIRE(publisher.GetChanges()[0].price_ == 1020);
+    REQUIRE(publisher.GetChanges()[0].quantity_ == 8);
+}
+
+TEST_CASE("trade tape test", "[unit]") {
+    lhft::book::TradeTape  tape(4, 2);
+    lhft::me::PooledMarket market;
+    lhft::book::Symbol     symbol = 1;
+    market.AddBook(symbol);
+    market.SetTradeTape(&tape);
+    for (lhft::book::OrderId order_id = 1; order_id <= 6; ++order_id) {
+        market.OrderSubmit(market.NewOrder(order_id, false, symbol, 1, 100 + order_id));
+    }
+    market.OrderSubmit(market.NewOrder(7, true, symbol, 3, 110));
+
+    lhft::book::TradeData trades[8];
+    REQUIRE(tape.Read(0, trades, 8) == 3);
+    REQUIRE(trades[0].stream_header_.seq_no_ == 1);
+    REQUIRE(trades[0].stream_header_.message_type_ == lhft::book::TRADE_EVENT_TICK);
+    REQUIRE(trades[0].buyer_id_ == 7);
+    REQUIRE(trades[0].seller_id_ == 1);
+    REQUIRE(trades[0].price_ == 101);
+    REQUIRE(trades[0].quantity_ == 1);
+    REQUIRE(trades[0].symbol_ == symbol);
+    REQUIRE_FALSE(trades[0].buyer_maker_);
+    REQUIRE(trades[2].fill_id_ == 3);
+
+    // The second reader has not read anything, so one more trade fits and the next two are dropped
+    market.OrderSubmit(market.NewOrder(8, true, symbol, 3, 110));
+    REQUIRE(tape.SeqNo() == 6);
+    REQUIRE(tape.Dropped() == 2);
+    REQUIRE(tape.Read(1, trades, 8) == 4);
+    REQUIRE(trades[3].stream_header_.seq_no_ == 4);
+    REQUIRE(tape.Read(0, trades, 8) == 1);
+    REQUIRE(trades[0].seller_id_ == 4);
+    REQUIRE(tape.Read(0, trades, 8) == 0);
+}
+
+TEST_CASE("trade tape consumers test", "[unit]") {
+    auto file_name = (std::filesystem::temp_directory_path() / "lhft_trade_tape_test.bin").string();
+
+    // One reader drains to a file in the background while the other feeds a publisher
+    lhft::book::TradeTape       tape(64, 2);
+    lhft::book::TradeFileWriter writer(tape, 0);
+    REQUIRE(writer.Start(file_name));
+    std::vector<lhft::book::TradeData> published;
+    lhft::book::TradePublisher publisher(tape, 1, [&published](const lhft::book::TradeData &trade) {
+        published.push_back(trade);
+    });
+
+    lhft::me::PooledMarket market;
+    market.AddBook(1);
+    market.SetTradeTape(&tape);
+    constexpr std::size_t trades = 500;
+    for (lhft::book::OrderId order_id = 1; order_id <= trades; ++order_id) {
+        market.OrderSubmit(market.NewOrder(2 * order_id, false, 1, 1, 100));
+        market.OrderSubmit(market.NewOrder(2 * order_id + 1, true, 1, 1, 100));
+        while (tape.SeqNo() - tape.Dropped() - published.size() >= tape.Capacity()) {
+            publisher.Poll();
+        }
+    }
+    while (published.size() + tape.Dropped() < trades) {
+        publisher.Poll();
+    }
+    writer.Stop();
+    REQUIRE(tape.SeqNo() == trades);
+    REQUIRE(writer.Written() == published.size());
+    REQUIRE_FALSE(published.empty());
+
+    std::vector<lhft::book::TradeData> written(writer.Written());
+    {
+        std::ifstream input(file_name, std::ios::binary);
+        input.read(reinterpret_cast<char *>(written.data()),
+                   static_cast<std::streamsize>(written.size() * sizeof(lhft::book::TradeData)));
+        REQUIRE(input.gcount() == static_cast<std::streamsize>(written.size() * sizeof(lhft::book::TradeData)));
+    }
+    for (std::size_t index = 0; index < written.size(); ++index) {
+        REQUIRE(written[index].stream_header_.seq_no_ == published[index].stream_header_.seq_no_);
+        REQUIRE(written[index].buyer_id_ == published[index].buyer_id_);
+        REQUIRE(written[index].seller_id_ == published[index].seller_id_);
+    }
+    std::filesystem::remove(file_name);
+}
+
+TEST_CASE("command journal replay test", "[unit]") {
+    using lhft::me::Command;
+    using lhft::me::CommandType;
+    auto file_name = (std::filesystem::temp_directory_path() / "lhft_journal_test.bin").string();
+    std::filesystem::remove(file_name);
+
+    lhft::book::TradeTape live_tape(64);
+    {
+        lhft::me::CommandJournal journal(4);
+        REQUIRE(journal.Open(file_name, 8));
+        lhft::me::PooledEngine engine(64, 8);
+        engine.SetJournal(&journal);
+        engine.GetMarket().SetTradeTape(&live_tape);
+
+        REQUIRE(engine.Submit({CommandType::ADD_BOOK, 0, false, 1, 0, 0}));
+        for (lhft::book::OrderId order_id = 1; order_id <= 20; ++order_id) {
+            REQUIRE(engine.Submit({CommandType::SUBMIT, order_id, order_id % 3 == 0, 1, order_id % 4 + 1,
+                                   100 + order_id % 5}));
+        }
+        REQUIRE(engine.Submit({CommandType::CANCEL, 2, false, 1, 0, 0}));
+        while (engine.Poll()) {
+        }
+        REQUIRE(journal.Size() == 22);
+        REQUIRE(journal.Committed() == 22);
+    }
+
+    lhft::me::JournalReader reader;
+    REQUIRE(reader.Open(file_name));
+    REQUIRE(reader.Size() == 22);
+    REQUIRE(reader.At(0).seq_no_ == 1);
+    REQUIRE(reader.At(0).command_.type_ == CommandType::ADD_BOOK);
+    REQUIRE(reader.At(21).command_.type_ == CommandType::CANCEL);
+    REQUIRE(reader.At(21).timestamp_ >= reader.At(0).timestamp_);
+
+    // Replay produces the same trades, in the same order, as the live run
+    lhft::book::TradeTape  replay_tape(64);
+    lhft::me::PooledMarket market;
+    market.SetTradeTape(&replay_tape);
+    REQUIRE(lhft::me::Replay(reader, market, 5) == 22);
+    REQUIRE(replay_tape.SeqNo() == live_tape.SeqNo());
+    REQUIRE(live_tape.SeqNo() > 0);
+    lhft::book::TradeData live[64];
+    lhft::book::TradeData replayed[64];
+    REQUIRE(live_tape.Read(0, live, 64) == replay_tape.Read(0, replayed, 64));
+    for (std::size_t index = 0; index < live_tape.SeqNo(); ++index) {
+        REQUIRE(live[index].buyer_id_ == replayed[index].buyer_id_);
+        REQUIRE(live[index].seller_id_ == replayed[index].seller_id_);
+        REQUIRE(live[index].quantity_ == replayed[index].quantity_);
+        REQUIRE(live[index].price_ == replayed[index].price_);
+        REQUIRE(live[index].fill_id_ == replayed[index].fill_id_);
+    }
+    reader.Close();
+
+    // Reopening appends after the last record
+    lhft::me::CommandJournal journal;
+    REQUIRE(journal.Open(file_name));
+    REQUIRE(journal.Size() == 22);
+    REQUIRE(journal.Append({CommandType::CANCEL, 3, false, 1, 0, 0}));
+    journal.Close();
+    REQUIRE(reader.Open(file_name));
+    REQUIRE(reader.Size() == 23);
+    REQUIRE(reader.At(22).seq_no_ == 23);
+    reader.Close();
+    std::filesystem::remove(file_name);
+}
+
+TEST_CASE("journal commit boundary test", "[unit]") {
+    using lhft::me::CommandType;
+    auto file_name = (std::filesystem::temp_directory_path() / "lhft_journal_commit_test.bin").string();
+    std::filesystem::remove(file_name);
+
+    // Appended but not committed records are in the shared map, yet readers stop at the commit
+    lhft::me::JournalReader reader;
+    {
+        lhft::me::CommandJournal journal(100);
+        REQUIRE(journal.Open(file_name, 8));
+        REQUIRE(journal.Append({CommandType::ADD_BOOK, 0, false, 1, 0, 0}));
+        REQUIRE(journal.Append({CommandType::SUBMIT, 1, true, 1, 10, 100}));
+        REQUIRE(journal.Commit());
+        REQUIRE(journal.Append({CommandType::SUBMIT, 2, false, 1, 10, 100}));
+        REQUIRE(journal.Append({CommandType::SUBMIT, 3, false, 1, 10, 90}));
+        REQUIRE(journal.Size() == 4);
+        REQUIRE(journal.Committed() == 2);
+
+        REQUIRE(reader.Open(file_name));
+        REQUIRE(reader.Size() == 2);
+        lhft::me::PooledMarket market;
+        REQUIRE(lhft::me::Replay(reader, market) == 2);
+        lhft::me::PooledMarket::OrderPtr     order;
+        lhft::me::PooledMarket::OrderBookPtr book;
+        REQUIRE(market.FindExistingOrder(1, order, book));
+        REQUIRE(order->QuantityFilled() == 0);
+        reader.Close();
+    }
+
+    // A run that stopped before committing leaves records past the header's count in the file.
+    // Pulling the count back to 2 stands for that: reopening drops records 3 and 4 and goes on at 3
+    {
+        std::fstream file(file_name, std::ios::binary | std::ios::in | std::ios::out);
+        uint64_t     committed = 2;
+        file.seekp(offsetof(lhft::me::JournalHeader, committed_));
+        file.write(reinterpret_cast<const char *>(&committed), sizeof(committed));
+    }
+    REQUIRE(reader.Open(file_name));
+    REQUIRE(reader.Size() == 2);
+    reader.Close();
+    {
+        lhft::me::CommandJournal journal;
+        REQUIRE(journal.Open(file_name, 8));
+        REQUIRE(journal.Size() == 2);
+        REQUIRE(journal.Append({CommandType::CANCEL, 1, false, 1, 0, 0}));
+    }
+    REQUIRE(reader.Open(file_name));
+    REQUIRE(reader.Size() == 3);
+    REQUIRE(reader.At(2).seq_no_ == 3);
+    REQUIRE(reader.At(2).command_.type_ == CommandType::CANCEL);
+    reader.Close();
+    std::filesystem::remove(file_name);
+}
+
+TEST_CASE("engine journal failure test", "[unit]") {
+    using lhft::me::CommandType;
+    // A journal that was never opened refuses every record
+    lhft::me::CommandJournal journal(4);
+    lhft::me::PooledEngine   engine(16, 4);
+    engine.SetJournal(&journal);
+    REQUIRE(engine.Submit({CommandType::ADD_BOOK, 0, false, 1, 0, 0}));
+    REQUIRE(engine.Submit({CommandType::SUBMIT, 1, true, 1, 10, 100}));
+    REQUIRE(engine.Poll() == 0);
+    REQUIRE(engine.Failed());
+    REQUIRE(engine.Processed() == 0);
+    REQUIRE_FALSE(engine.GetMarket().FindBook(1));
+
+    // Nothing is applied from then on, with or without the polling thread
+    REQUIRE(engine.Submit({CommandType::ADD_BOOK, 0, false, 2, 0, 0}));
+    REQUIRE(engine.Poll() == 0);
+    engine.Start();
+    engine.Stop();
+    REQUIRE_FALSE(engine.GetMarket().FindBook(2));
+}
+
+TEST_CASE("book snapshot restore test", "[unit]") {
+    auto file_name = (std::filesystem::temp_directory_path() / "lhft_snapshot_test.bin").string();
+
+    lhft::me::PooledMarket market;
+    market.AddBook(1);
+    market.AddBook(2);
+    for (lhft::book::OrderId order_id = 1; order_id <= 30; ++order_id) {
+        market.OrderSubmit(market.NewOrder(order_id, order_id % 2 == 0, 1 + order_id / 2 % 2, order_id % 5 + 1,
+                                           order_id % 2 == 0 ? 100 - order_id % 4 : 101 + order_id % 4));
+    }
+    market.OrderSubmit(market.NewOrder(31, true, 1, 7, 103));
+    market.OrderSubmit(market.NewOrder(33, false, 1, 3, 0, 50));    // waiting stop
+    REQUIRE(market.FindBook(1)->GetSellStops().size() == 1);
+    auto owned = market.NewOrder(34, true, 1, 2, 90);
+    owned->SetOwner(7);
+    owned->SetPostOnly(true);
+    REQUIRE(market.OrderSubmit(owned));
+    auto ioc_stop = market.NewOrder(35, true, 2, 100, 104, 104);    // waiting stop, book 2 has not traded
+    ioc_stop->SetTimeInForce(lhft::book::TimeInForce::IOC);
+    REQUIRE(market.OrderSubmit(ioc_stop));
+    REQUIRE(market.FindBook(2)->GetBuyStops().size() == 1);
+    REQUIRE(market.AuctionBegin(1));
+    REQUIRE(market.SaveSnapshot(file_name, 42));
+
+    // Saving the same market twice gives the same bytes
+    auto read_file = [](const std::string &name) {
+        std::ifstream input(name, std::ios::binary);
+        return std::string(std::istreambuf_iterator<char>(input), std::istreambuf_iterator<char>());
+    };
+    auto again_name = file_name + ".again";
+    REQUIRE(market.SaveSnapshot(again_name, 42));
+    REQUIRE(read_file(again_name) == read_file(file_name));
+    std::filesystem::remove(again_name);
+
+    lhft::me::PooledMarket restored;
+    uint64_t               journal_seq_no = 0;
+    REQUIRE(restored.RestoreSnapshot(file_name, journal_seq_no));
+    REQUIRE(journal_seq_no == 42);
+    REQUIRE_FALSE(restored.RestoreSnapshot(file_name, journal_seq_no));
+
+    // Same books, same levels, same queue order and open quantities
+    for (lhft::book::Symbol symbol = 1; symbol <= 2; ++symbol) {
+        auto original = market.FindBook(symbol);
+        auto copy     = restored.FindBook(symbol);
+        REQUIRE(copy);
+        REQUIRE(copy->MarketPrice() == original->MarketPrice());
+        REQUIRE(copy->InAuction() == original->InAuction());
+        REQUIRE(copy->GetListener().GetFillId() == original->GetListener().GetFillId());
+        REQUIRE(copy->GetSellStops().size() == original->GetSellStops().size());
+        for (bool buy_side : {true, false}) {
+            const auto &lhs = buy_side ? original->GetBids() : original->GetAsks();
+            const auto &rhs = buy_side ? copy->GetBids() : copy->GetAsks();
+            REQUIRE(lhs.size() == rhs.size());
+            auto entry = rhs.begin();
+            for (const auto &expected : lhs) {
+                REQUIRE(entry->tracker_.Ptr()->GetOrderId() == expected.tracker_.Ptr()->GetOrderId());
+                REQUIRE(entry->tracker_.OpenQty() == expected.tracker_.OpenQty());
+                REQUIRE(entry->tracker_.Ptr()->QuantityFilled() == expected.tracker_.Ptr()->QuantityFilled());
+                ++entry;
+            }
+        }
+    }
+
+    // The restored market keeps matching and cancelling as the original would
+    lhft::me::PooledMarket::OrderPtr     order;
+    lhft::me::PooledMarket::OrderBookPtr book;
+    REQUIRE(restored.FindExistingOrder(34, order, book));
+    REQUIRE(order->GetOwner() == 7);
+    REQUIRE(order->IsPostOnly());
+    REQUIRE(restored.FindExistingOrder(2, order, book));
+    REQUIRE(order->GetOwner() == lhft::book::ANY_OWNER);
+    REQUIRE_FALSE(order->IsPostOnly());
+
+    // A trade at 104 releases the IOC stop, it takes every ask left and its remainder is dropped
+    REQUIRE(restored.FindExistingOrder(35, order, book));
+    REQUIRE(order->GetTimeInForce() == lhft::book::TimeInForce::IOC);
+    REQUIRE(restored.OrderSubmit(restored.NewOrder(36, true, 2, 1, 104)));
+    REQUIRE(restored.FindBook(2)->GetBuyStops().empty());
+    REQUIRE(restored.FindBook(2)->GetAsks().empty());
+    REQUIRE(restored.FindBook(2)->GetBids().begin()->price_.GetPrice() == 98);
+    REQUIRE_FALSE(restored.FindExistingOrder(35, order, book));
+    REQUIRE(restored.OrderCancel(2));
+    REQUIRE(restored.OrderSubmit(restored.NewOrder(32, false, 2, 50, 1)));
+    REQUIRE(restored.FindBook(2)->GetBids().empty());
+    REQUIRE(restored.FindBook(1)->InAuction());
+    REQUIRE(restored.AuctionUncross(1) == market.AuctionUncross(1));
+    REQUIRE(restored.OwnerMassCancel(7) == 1);
+
+    // A truncated file or a repeated order id is refused without loading anything
+    auto contents = read_file(file_name);
+    auto rewrite = [&](const std::string &bytes) {
+        std::ofstream output(file_name, std::ios::binary | std::ios::trunc);
+        output.write(bytes.data(), static_cast<std::streamsize>(bytes.size()));
+    };
+    rewrite(contents.substr(0, contents.size() - sizeof(lhft::book::RestingOrder) / 2));
+    lhft::me::PooledMarket truncated;
+    REQUIRE_FALSE(truncated.RestoreSnapshot(file_name, journal_seq_no));
+    REQUIRE_FALSE(truncated.FindBook(1));
+    REQUIRE_FALSE(truncated.FindBook(2));
+
+    auto                     duplicated = contents;
+    lhft::book::RestingOrder first;
+    lhft::book::RestingOrder second;
+    auto offset = sizeof(lhft::book::SnapshotHeader) + sizeof(lhft::book::BookSnapshot);
+    std::memcpy(&first, duplicated.data() + offset, sizeof(first));
+    std::memcpy(&second, duplicated.data() + offset + sizeof(first), sizeof(second));
+    second.id_ = first.id_;
+    std::memcpy(duplicated.data() + offset + sizeof(first), &second, sizeof(second));
+    rewrite(duplicated);
+    lhft::me::PooledMarket repeated;
+    REQUIRE_FALSE(repeated.RestoreSnapshot(file_name, journal_seq_no));
+    REQUIRE_FALSE(repeated.FindBook(1));
+    lhft::me::PooledMarket::OrderPtr     missing;
+    lhft::me::PooledMarket::OrderBookPtr missing_book;
+    REQUIRE_FALSE(repeated.FindExistingOrder(first.id_, missing, missing_book));
+
+    // Counts in the header that the file can't hold are refused before anything is allocated
+    lhft::book::SnapshotHeader header;
+    for (bool books : {true, false}) {
+        auto oversized = contents;
+        std::memcpy(&header, oversized.data(), sizeof(header));
+        if (books) {
+            header.books_ = UINT32_MAX;
+        } else {
+            header.orders_ = UINT64_MAX;
+        }
+        std::memcpy(oversized.data(), &header, sizeof(header));
+        rewrite(oversized);
+        lhft::me::PooledMarket huge;
+        REQUIRE_FALSE(huge.RestoreSnapshot(file_name, journal_seq_no));
+        REQUIRE_FALSE(huge.FindBook(1));
+    }
+    std::filesystem::remove(file_name);
+}
+
+TEST_CASE("order file parser test", "[unit]") {
+    std::string_view data =
+            "A,100000,S,1,1075\n"
+            "A,100001,B,9,1000,7\r\n"
+            "\n"
+            "A,100002,B,3,1050 \n"
+            "X,100001,B,9,1000\n"
+            "A,100003,Q,3,1050\n"
+            "A,100004,B,,1050\n"
+            "A,100005,B,3,10x0\n"
+            "X,100002";
+    lhft::me::OrderFileParser parser(data, 5);
+    lhft::me::Command         commands[8];
+    REQUIRE(parser.Next(commands, 8) == 5);
+    REQUIRE(parser.Lines() == 9);
+    REQUIRE(parser.Errors() == 3);
+
+    REQUIRE(commands[0].type_ == lhft::me::CommandType::SUBMIT);
+    REQUIRE(commands[0].order_id_ == 100000);
+    REQUIRE_FALSE(commands[0].buy_side_);
+    REQUIRE(commands[0].symbol_ == 5);
+    REQUIRE(commands[0].quantity_ == 1);
+    REQUIRE(commands[0].price_ == 1075);
+
+    REQUIRE(commands[1].buy_side_);
+    REQUIRE(commands[1].symbol_ == 7);
+    REQUIRE(commands[2].price_ == 1050);
+    REQUIRE(commands[3].type_ == lhft::me::CommandType::CANCEL);
+    REQUIRE(commands[3].order_id_ == 100001);
+    REQUIRE(commands[4].order_id_ == 100002);
+    REQUIRE(parser.Next(commands, 8) == 0);
+
+    auto file_name = (std::filesystem::temp_directory_path() / "lhft_order_file_test.csv").string();
+    std::ofstream(file_name) << data;
+    lhft::me::MappedFile file;
+    REQUIRE(file.Open(file_name));
+    REQUIRE(file.Data() == data);
+    file.Close();
+    std::filesystem::remove(file_name);
+}
+
+TEST_CASE("binary order entry codec test", "[unit]") {
+    using lhft::me::CommandType;
+    using lhft::me::OrderType;
+    using lhft::me::Side;
+
+    lhft::me::MessageEncoder encoder;
+    encoder.AddOrder(1, Side::SELL, 1, 10, 101);
+    encoder.AddOrder(0x1'0000'0002, Side::BUY, 70000, 5, 100);
+    encoder.AddOrder(3, Side::BUY, 1, 4, 0, OrderType::MARKET);
+    encoder.AddOrder(4, Side::BUY, 1, 4, 0);    // limit without a price
+    encoder.CancelOrder(0x1'0000'0002, 70000);
+    encoder.ReplaceOrder(1, 1, 8, 102);
+    encoder.MassCancel(1);
+    encoder.AddOrder(5, Side::BUY, 1, 2, 0, OrderType::MARKET, lhft::book::TimeInForce::GTC, false, 150);
+    encoder.MassCancel(70000, Side::SELL, 3);
+    // Unknown message, stepped over by its length
+    const std::byte unknown[] = {std::byte{4}, std::byte{0}, std::byte{'Z'}, std::byte{0}};
+    std::vector<std::byte> stream(encoder.Data(), encoder.Data() + encoder.Size());
+    stream.insert(stream.begin() + sizeof(lhft::me::AddOrderMessage), std::begin(unknown), std::end(unknown));
+
+    // Fed a few bytes at a time, the way a socket delivers them
+    lhft::me::MessageDecoder       decoder;
+    std::vector<lhft::me::Command> commands;
+    std::vector<std::byte>         pending;
+    for (std::size_t offset = 0; offset < stream.size(); offset += 11) {
+        pending.insert(pending.end(), stream.begin() + offset,
+                       stream.begin() + (std::min)(offset + 11, stream.size()));
+        auto consumed = decoder.Decode(pending.data(), pending.size(),
+                                       [&](const lhft::me::Command &command) { commands.push_back(command); });
+        pending.erase(pending.begin(), pending.begin() + consumed);
+    }
+    REQUIRE(pending.empty());
+    REQUIRE(decoder.Errors() == 2);
+    REQUIRE_FALSE(decoder.Broken());
+    REQUIRE(commands.size() == 8);
+
+    REQUIRE(commands[0].type_ == CommandType::SUBMIT);
+    REQUIRE_FALSE(commands[0].buy_side_);
+    REQUIRE(commands[0].price_ == 101);
+    REQUIRE(commands[1].order_id_ == 0x1'0000'0002);
+    REQUIRE(commands[1].symbol_ == 70000);
+    REQUIRE(commands[1].buy_side_);
+    REQUIRE(commands[1].quantity_ == 5);
+    REQUIRE(commands[2].price_ == lhft::book::MARKET_ORDER_PRICE);
+    REQUIRE(commands[3].type_ == CommandType::CANCEL);
+    REQUIRE(commands[3].order_id_ == 0x1'0000'0002);
+    REQUIRE(commands[4].type_ == CommandType::REPLACE);
+    REQUIRE(commands[4].quantity_ == 8);
+    REQUIRE(commands[4].price_ == 102);
+    REQUIRE(commands[5].type_ == CommandType::MASS_CANCEL);
+    REQUIRE(commands[5].symbol_ == 1);
+    REQUIRE(commands[6].price_ == lhft::book::MARKET_ORDER_PRICE);
+    REQUIRE(commands[6].stop_price_ == 150);
+    REQUIRE(commands[5].cancel_bids_);
+    REQUIRE(commands[5].cancel_asks_);
+    REQUIRE(commands[5].owner_ == lhft::book::ANY_OWNER);
+    REQUIRE(commands[7].type_ == CommandType::MASS_CANCEL);
+    REQUIRE_FALSE(commands[7].cancel_bids_);
+    REQUIRE(commands[7].cancel_asks_);
+    REQUIRE(commands[7].owner_ == 3);
+    REQUIRE(commands[0].stop_price_ == 0);
+
+    // Straight into a market
+    lhft::me::Market market;
+    market.AddBook(1);
+    market.AddBook(70000);
+    lhft::me::MessageDecoder dispatcher;
+    REQUIRE(lhft::me::Dispatch(dispatcher, stream.data(), stream.size(), market, 2) == stream.size());
+    REQUIRE(market.FindBook(1)->GetBids().empty());
+    REQUIRE(market.FindBook(1)->GetAsks().empty());
+    REQUIRE(market.FindBook(70000)->GetBids().empty());
+    REQUIRE(market.FindBook(1)->GetBuyStops().size() == 1);
+
+    // An owner entered with the order is the one a mass cancel goes by
+    encoder.Clear();
+    encoder.AddOrder(10, Side::BUY, 1, 3, 99, OrderType::LIMIT, lhft::book::TimeInForce::GTC, false, 0, 7);
+    encoder.AddOrder(11, Side::BUY, 1, 3, 98);
+    encoder.MassCancel(1, Side::BOTH, 7);
+    commands.clear();
+    lhft::me::MessageDecoder owned;
+    owned.Decode(encoder.Data(), encoder.Size(),
+                 [&](const lhft::me::Command &command) { commands.push_back(command); });
+    REQUIRE(commands.size() == 3);
+    REQUIRE(commands[0].owner_ == 7);
+    REQUIRE(commands[1].owner_ == lhft::book::ANY_OWNER);
+    REQUIRE(lhft::me::Dispatch(owned, encoder.Data(), encoder.Size(), market) == encoder.Size());
+    lhft::me::Market::OrderPtr     order;
+    lhft::me::Market::OrderBookPtr book;
+    REQUIRE_FALSE(market.FindExistingOrder(10, order, book));
+    REQUIRE(market.FindExistingOrder(11, order, book));
+    REQUIRE(market.FindBook(1)->GetBids().size() == 1);
+
+    // A length shorter than a header can't be stepped over
+    const std::byte broken[] = {std::byte{1}, std::byte{0}, std::byte{'A'}, std::byte{0}};
+    REQUIRE(dispatcher.Decode(broken, sizeof(broken), [](const lhft::me::Command &) {}) == 0);
+    REQUIRE(dispatcher.Broken());
+}
+
+TEST_CASE("latency histogram test", "[unit]") {
+    using lhft::perf::Histogram;
+    // Every value lands in a bucket whose upper edge is within 1/32 above it
+    for (uint64_t value : {0ULL, 1ULL, 31ULL, 32ULL, 33ULL, 1000ULL, 123456789ULL, ~0ULL}) {
+        auto index = Histogram::Index(value);
+        REQUIRE(index < Histogram::BUCKETS);
+        REQUIRE(Histogram::UpperBound(index) >= value);
+        REQUIRE(Histogram::UpperBound(index) - value <= value / Histogram::SUB_BUCKETS);
+        if (index > 0) {
+            REQUIRE(Histogram::UpperBound(index - 1) < value);
+        }
+    }
+
+    auto histogram = std::make_unique<Histogram>();
+    for (uint64_t value = 1; value <= 1000; ++value) {
+        histogram->Record(value);
+    }
+    histogram->Record(1'000'000);
+    REQUIRE(histogram->Count() == 1001);
+    REQUIRE(histogram->Max() == 1'000'000);
+    REQUIRE(histogram->Percentile(50) >= 500);
+    REQUIRE(histogram->Percentile(50) <= 500 + 500 / Histogram::SUB_BUCKETS);
+    REQUIRE(histogram->Percentile(99) >= 990);
+    REQUIRE(histogram->Percentile(99) <= 990 + 990 / Histogram::SUB_BUCKETS);
+    REQUIRE(histogram->Percentile(100) == 1'000'000);
+
+    // Threads record into their own histograms, a collect sees all of them
+    auto &registry = lhft::perf::LatencyRegistry::Instance();
+    registry.Reset();
+    std::thread first([&] {
+        for (int count = 0; count < 100; ++count) {
+            registry.Record(lhft::perf::Probe::DECODE, 10);
+        }
+    });
+    std::thread second([&] {
+        for (int count = 0; count < 50; ++count) {
+            registry.Record(lhft::perf::Probe::DECODE, 20);
+        }
+    });
+    first.join();
+    second.join();
+    auto decode = std::make_unique<Histogram>();
+    registry.Collect(lhft::perf::Probe::DECODE, *decode);
+    REQUIRE(decode->Count() == 150);
+    REQUIRE(decode->Max() == 20);
+
+#ifdef LATENCY_ENABLE
+    lhft::me::PooledMarket market;
+    market.AddBook(1);
+    market.OrderSubmit(market.NewOrder(1, true, 1, 10, 100));
+    market.OrderSubmit(market.NewOrder(2, false, 1, 4, 100));
+    REQUIRE(market.OrderCancel(1));
+    for (auto probe : {lhft::perf::Probe::ADD, lhft::perf::Probe::ADD_FILL, lhft::perf::Probe::CANCEL}) {
+        auto operation = std::make_unique<Histogram>();
+        registry.Collect(probe, *operation);
+        REQUIRE(operation->Count() == 1);
+    }
+    std::ostringstream report;
+    registry.Dump(report);
+    REQUIRE(report.str().find("add with fill") != std::string::npos);
+#endif
+    registry.Reset();
+}